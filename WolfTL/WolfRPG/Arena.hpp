@@ -0,0 +1,85 @@
+/*
+ *  File: Arena.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include "Types.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+
+// Monotonic arena for the object graph of a single file.
+// Objects constructed while an Arena::Scope is active take their allocator from that scope, i.e.,
+// parsing a file only requires a few large allocations and freeing the arena releases everything at once.
+// The arena has to outlive every object allocated from it, therefore it is owned by the file object (see WolfDataBase).
+class Arena
+{
+public:
+	using Resource = std::pmr::monotonic_buffer_resource;
+
+	class Scope
+	{
+	public:
+		DISABLE_COPY_MOVE(Scope)
+
+		explicit Scope(std::pmr::memory_resource* pResource) :
+			m_pPrevious(s_pCurrent)
+		{
+			s_pCurrent = pResource;
+		}
+
+		~Scope()
+		{
+			s_pCurrent = m_pPrevious;
+		}
+
+	private:
+		std::pmr::memory_resource* m_pPrevious;
+	};
+
+	// Creates a new arena, the first block is sized based on the size of the file that is going to be parsed
+	static std::unique_ptr<Resource> Create(const std::size_t& fileSize)
+	{
+		return std::make_unique<Resource>(std::max(fileSize * 2, MIN_BLOCK_SIZE));
+	}
+
+	static std::pmr::memory_resource* Current()
+	{
+		return s_pCurrent ? s_pCurrent : std::pmr::get_default_resource();
+	}
+
+	template<typename T = std::byte>
+	static std::pmr::polymorphic_allocator<T> Allocator()
+	{
+		return std::pmr::polymorphic_allocator<T>(Current());
+	}
+
+private:
+	static constexpr std::size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+	inline static thread_local std::pmr::memory_resource* s_pCurrent = nullptr;
+};
@@ -0,0 +1,179 @@
+/*
+ *  File: Bundle.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "FileAccess.hpp"
+#include "Types.hpp"
+#include "WolfRPGException.hpp"
+#include "WolfRPGUtils.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Single file container for the JSON dump, every dump file is stored as one entry of the bundle.
+// Layout: magic, version, entry count, index (name, 64 bit offset and size of every entry) followed by the content of the entries.
+// The bundle represents the folder it is placed in, i.e., the entries are addressed by their path relative to that folder.
+// The index allows random access to every entry, the file is opened and mapped once and as the entries are
+// independent JSON documents they can be parsed in parallel.
+class Bundle
+{
+public:
+	class Writer
+	{
+	public:
+		explicit Writer(const std::filesystem::path& basePath) :
+			m_basePath(basePath)
+		{
+		}
+
+		DISABLE_COPY_MOVE(Writer)
+
+		// Thread safe, the entries are stored in the order they were added
+		void Add(const std::filesystem::path& filePath, Bytes data)
+		{
+			const std::string name = entryName(m_basePath, filePath);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_entries.push_back({ name, std::move(data) });
+		}
+
+		void Write(const std::filesystem::path& filePath) const
+		{
+			uint64_t indexSize = HEADER_SIZE;
+			for (const Entry& entry : m_entries)
+				indexSize += sizeof(uint32_t) + entry.name.size() + sizeof(uint64_t) * 2;
+
+			FileWriter writer(filePath);
+			writer.Write(MAGIC);
+			writer.Write(VERSION);
+			writer.Write(static_cast<uint32_t>(m_entries.size()));
+
+			uint64_t offset = indexSize;
+			for (const Entry& entry : m_entries)
+			{
+				writer.Write(static_cast<uint32_t>(entry.name.size()));
+				writer.WriteBytes(entry.name.data(), entry.name.size());
+				writer.Write(offset);
+				writer.Write(static_cast<uint64_t>(entry.data.size()));
+
+				offset += entry.data.size();
+			}
+
+			for (const Entry& entry : m_entries)
+				writer.WriteBytesVec(entry.data);
+		}
+
+	private:
+		struct Entry
+		{
+			std::string name;
+			Bytes data;
+		};
+
+		std::filesystem::path m_basePath;
+		std::vector<Entry> m_entries = {};
+		std::mutex m_mutex           = {};
+	};
+
+	explicit Bundle(const std::filesystem::path& filePath) :
+		m_basePath(filePath.parent_path()),
+		m_reader(filePath)
+	{
+		const char* pData = reinterpret_cast<const char*>(m_reader.Get());
+
+		if (m_reader.ReadUInt32() != MAGIC)
+			throw WolfRPGException(std::format(L"{}Not a dump bundle: {}", ERROR_TAGW, filePath.wstring()));
+
+		const uint32_t version = m_reader.ReadUInt32();
+		if (version != VERSION)
+			throw WolfRPGException(std::format(L"{}Unsupported bundle version {}: {}", ERROR_TAGW, version, filePath.wstring()));
+
+		const uint32_t count = m_reader.ReadUInt32();
+		m_index.reserve(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const uint32_t nameSize = m_reader.ReadUInt32();
+			const uint32_t nameOffs = m_reader.GetOffset();
+			m_reader.Skip(nameSize);
+
+			const uint64_t offset = m_reader.ReadUInt64();
+			const uint64_t size   = m_reader.ReadUInt64();
+
+			// The entries are accessed through the mapping, i.e., they can be located beyond the first 4 GiB of the file
+			if (offset > m_reader.GetMappedSize() || size > m_reader.GetMappedSize() - offset)
+				throw WolfRPGException(std::format(L"{}Bundle entry {} exceeds the file size: {}", ERROR_TAGW, i, filePath.wstring()));
+
+			m_index.emplace(std::string(pData + nameOffs, nameSize), std::string_view(pData + offset, size));
+		}
+	}
+
+	DISABLE_COPY_MOVE(Bundle)
+
+	bool Contains(const std::filesystem::path& filePath) const
+	{
+		return m_index.contains(entryName(m_basePath, filePath));
+	}
+
+	// Content of the entry standing in for filePath, valid as long as the bundle exists
+	std::string_view Get(const std::filesystem::path& filePath) const
+	{
+		const auto it = m_index.find(entryName(m_basePath, filePath));
+		if (it == m_index.end())
+			throw WolfRPGException(std::format(L"{}File not found in bundle: {}", ERROR_TAGW, filePath.wstring()));
+
+		return it->second;
+	}
+
+	std::size_t Size() const
+	{
+		return m_index.size();
+	}
+
+private:
+	static std::string entryName(const std::filesystem::path& basePath, const std::filesystem::path& filePath)
+	{
+		const std::u8string name = filePath.lexically_relative(basePath).generic_u8string();
+		return std::string(name.begin(), name.end());
+	}
+
+private:
+	static constexpr uint32_t MAGIC       = 0x424C5457; // "WTLB"
+	static constexpr uint32_t VERSION     = 2;
+	static constexpr uint32_t HEADER_SIZE = sizeof(uint32_t) * 3;
+
+	std::filesystem::path m_basePath;
+	FileReader m_reader;
+	std::unordered_map<std::string, std::string_view> m_index = {};
+};
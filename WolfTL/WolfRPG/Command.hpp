@@ -74,13 +74,22 @@ arg[0] >= 3000000 && arg[0] < 4000000
 
 #pragma once
 
+#include "Arena.hpp"
 #include "FileCoder.hpp"
+#include "JsonWriter.hpp"
 #include "RouteCommand.hpp"
+#include "SmallVector.hpp"
+#include "TextTable.hpp"
 #include "WolfRPGUtils.hpp"
 
 #include <algorithm>
+#include <array>
 #include <memory>
 #include <nlohmann/json.hpp>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <variant>
 
 namespace Command
 {
@@ -161,14 +170,30 @@ enum class CommandType
 	Invalid            = -1
 };
 
+// Inline capacities which cover the argument counts of the common commands, can be checked with --arg_stats
+using IntArgs    = SmallVector<uint32_t, 8>;
+using StringArgs = SmallVector<PooledString, 4>;
+
+// Common part of all commands, read before it is known which class the command belongs to
+struct RawCommand
+{
+	CommandType cid       = CommandType::Invalid;
+	IntArgs args          = {};
+	StringArgs stringArgs = {};
+	uint8_t indent        = 0;
+};
+
+struct CommandInfo;
+
 class Command
 {
 public:
-	Command(const CommandType& cid = CommandType::Default, const uInts& args = uInts(), const tStrings& stringArgs = tStrings(), const uint8_t& indent = -1) :
+	Command(const CommandType& cid = CommandType::Default, IntArgs args = IntArgs(), StringArgs stringArgs = StringArgs(), const uint8_t& indent = -1) :
 		m_cid(cid),
-		m_args(args),
-		m_stringArgs(stringArgs),
-		m_indent(indent)
+		m_args(std::move(args)),
+		m_stringArgs(std::move(stringArgs)),
+		m_indent(indent),
+		m_v35Unknown(Arena::Allocator())
 	{
 	}
 
@@ -179,6 +204,11 @@ public:
 
 	static std::shared_ptr<Command> Init(FileCoder& coder);
 
+	// Moves the coder behind the next command without parsing it, has to follow the layout read by Init
+	static void Skip(FileCoder& coder);
+
+	friend class Commands;
+
 	void DumpData(FileCoder& coder) const
 	{
 		coder.WriteByte((uint8_t)m_args.size() + 1);
@@ -187,7 +217,7 @@ public:
 			coder.WriteInt(arg);
 		coder.WriteByte(m_indent);
 		coder.WriteByte((uint8_t)m_stringArgs.size());
-		for (tString arg : m_stringArgs)
+		for (const PooledString& arg : m_stringArgs)
 			coder.WriteString(arg);
 	}
 
@@ -195,7 +225,11 @@ public:
 	{
 		DumpData(coder);
 		DumpTerminator(coder);
+		DumpV35Trailer(coder);
+	}
 
+	void DumpV35Trailer(FileCoder& coder) const
+	{
 		if (s_v35)
 		{
 			coder.WriteByte(static_cast<uint8_t>(m_v35Unknown.size()));
@@ -204,32 +238,39 @@ public:
 		}
 	}
 
-	virtual nlohmann::ordered_json ToJson() const
+	// Commands without arguments are not exported
+	virtual void WriteJson(JsonWriter& writer, const std::size_t& index) const
 	{
-		if (m_stringArgs.empty() && m_args.empty())
-			return nlohmann::ordered_json();
+		if (m_stringArgs.empty() && m_args.empty()) return;
 
-		nlohmann::ordered_json json;
-		json["code"]    = static_cast<int32_t>(m_cid);
-		json["codeStr"] = ToUTF8(GetClassString());
+		writer.BeginObject();
+		writer.Value("code", static_cast<int32_t>(m_cid));
+		writer.Value("codeStr", GetClassName());
 
 		if (!m_stringArgs.empty())
 		{
-			json["stringArgs"] = nlohmann::ordered_json::array();
+			writer.Key("stringArgs");
+			writer.BeginArray();
+
+			for (const PooledString& arg : m_stringArgs)
+				writer.Value(arg.UTF8());
 
-			for (const tString& arg : m_stringArgs)
-				json["stringArgs"].push_back(ToUTF8(arg));
+			writer.EndArray();
 		}
 
 		if (!m_args.empty())
 		{
-			json["intArgs"] = nlohmann::ordered_json::array();
+			writer.Key("intArgs");
+			writer.BeginArray();
 
 			for (const uint32_t& arg : m_args)
-				json["intArgs"].push_back(arg);
+				writer.Value(arg);
+
+			writer.EndArray();
 		}
 
-		return json;
+		writer.Value("index", index);
+		writer.EndObject();
 	}
 
 	virtual void Patch(const nlohmann::ordered_json& j)
@@ -238,16 +279,24 @@ public:
 
 		if (j.contains("stringArgs"))
 		{
-			m_stringArgs.clear();
+			StringArgs stringArgs;
 			for (const auto& arg : j["stringArgs"])
-				m_stringArgs.push_back(ToUTF16(arg));
+				stringArgs.push_back(PooledString::FromUTF8(arg));
+
+			setStringArgs(std::move(stringArgs));
 		}
 
 		if (j.contains("intArgs"))
 		{
-			m_args.clear();
+			IntArgs args;
 			for (const auto& arg : j["intArgs"])
-				m_args.push_back(arg);
+				args.push_back(arg);
+
+			if (args != m_args)
+			{
+				m_args  = std::move(args);
+				m_dirty = true;
+			}
 		}
 	}
 
@@ -261,137 +310,19 @@ public:
 		return m_cid;
 	}
 
+	const uint8_t& GetIndent() const
+	{
+		return m_indent;
+	}
+
 	const tString GetClassString() const
 	{
-		switch (m_cid)
-		{
-			case CommandType::Blank:
-				return L"Blank";
-			case CommandType::Checkpoint:
-				return L"Checkpoint";
-			case CommandType::Message:
-				return L"Message";
-			case CommandType::Choices:
-				return L"Choices";
-			case CommandType::Comment:
-				return L"Comment";
-			case CommandType::ForceStopMessage:
-				return L"ForceStopMessage";
-			case CommandType::DebugMessage:
-				return L"DebugMessage";
-			case CommandType::ClearDebugText:
-				return L"ClearDebugText";
-			case CommandType::VariableCondition:
-				return L"VariableCondition";
-			case CommandType::StringCondition:
-				return L"StringCondition";
-			case CommandType::SetVariable:
-				return L"SetVariable";
-			case CommandType::SetString:
-				return L"SetString";
-			case CommandType::InputKey:
-				return L"InputKey";
-			case CommandType::SetVariableEx:
-				return L"SetVariableEx";
-			case CommandType::AutoInput:
-				return L"AutoInput";
-			case CommandType::BanInput:
-				return L"BanInput";
-			case CommandType::Teleport:
-				return L"Teleport";
-			case CommandType::Sound:
-				return L"Sound";
-			case CommandType::Picture:
-				return L"Picture";
-			case CommandType::ChangeColor:
-				return L"ChangeColor";
-			case CommandType::SetTransition:
-				return L"SetTransition";
-			case CommandType::PrepareTransition:
-				return L"PrepareTransition";
-			case CommandType::ExecuteTransition:
-				return L"ExecuteTransition";
-			case CommandType::StartLoop:
-				return L"StartLoop";
-			case CommandType::BreakLoop:
-				return L"BreakLoop";
-			case CommandType::BreakEvent:
-				return L"BreakEvent";
-			case CommandType::EraseEvent:
-				return L"EraseEvent";
-			case CommandType::ReturnToTitle:
-				return L"ReturnToTitle";
-			case CommandType::EndGame:
-				return L"EndGame";
-			case CommandType::StartLoop2:
-				return L"StartLoop";
-			case CommandType::StopNonPic:
-				return L"StopNonPic";
-			case CommandType::ResumeNonPic:
-				return L"ResumeNonPic";
-			case CommandType::LoopTimes:
-				return L"LoopTimes";
-			case CommandType::Wait:
-				return L"Wait";
-			case CommandType::Move:
-				return L"Move";
-			case CommandType::WaitForMove:
-				return L"WaitForMove";
-			case CommandType::CommonEvent:
-				return L"CommonEvent";
-			case CommandType::CommonEventReserve:
-				return L"CommonEventReserve";
-			case CommandType::SetLabel:
-				return L"SetLabel";
-			case CommandType::JumpLabel:
-				return L"JumpLabel";
-			case CommandType::SaveLoad:
-				return L"SaveLoad";
-			case CommandType::LoadGame:
-				return L"LoadGame";
-			case CommandType::SaveGame:
-				return L"SaveGame";
-			case CommandType::MoveDuringEventOn:
-				return L"MoveDuringEventOn";
-			case CommandType::MoveDuringEventOff:
-				return L"MoveDuringEventOff";
-			case CommandType::Chip:
-				return L"Chip";
-			case CommandType::ChipSet:
-				return L"ChipSet";
-			case CommandType::Database:
-				return L"Database";
-			case CommandType::ImportDatabase:
-				return L"ImportDatabase";
-			case CommandType::Party:
-				return L"Party";
-			case CommandType::MapEffect:
-				return L"MapEffect";
-			case CommandType::ScrollScreen:
-				return L"ScrollScreen";
-			case CommandType::Effect:
-				return L"Effect";
-			case CommandType::CommonEventByName:
-				return L"CommonEventByName";
-			case CommandType::ChoiceCase:
-				return L"ChoiceCase";
-			case CommandType::SpecialChoiceCase:
-				return L"SpecialChoiceCase";
-			case CommandType::ElseCase:
-				return L"ElseCase";
-			case CommandType::CancelCase:
-				return L"CancelCase";
-			case CommandType::LoopEnd:
-				return L"LoopEnd";
-			case CommandType::BranchEnd:
-				return L"BranchEnd";
-			case CommandType::Default:
-				return L"Command";
-			default:
-				return L"Command";
-		}
+		const std::string_view name = GetClassName();
+		return tString(name.begin(), name.end());
 	}
 
+	std::string_view GetClassName() const;
+
 	virtual const tString Text() const
 	{
 		if (m_stringArgs.empty()) return L"";
@@ -403,15 +334,15 @@ public:
 		if (m_stringArgs.size() <= index)
 			throw WolfRPGException(std::format(L"{}setText({}, {}) index out of range (size: {})", ERROR_TAGW, value, index, m_stringArgs.size()));
 
-		m_stringArgs[index] = value;
+		setStringArg(index, value);
 	}
 
-	virtual const tStrings& Texts() const
+	virtual const StringArgs& Texts() const
 	{
 		return m_stringArgs;
 	}
 
-	virtual const uInts& GetIntArgs() const
+	virtual const IntArgs& GetIntArgs() const
 	{
 		return m_args;
 	}
@@ -442,28 +373,80 @@ public:
 
 	void SetV35Unknown(const Bytes& unknown)
 	{
-		m_v35Unknown = unknown;
+		m_v35Unknown.assign(unknown.begin(), unknown.end());
+		m_dirty = true;
+	}
+
+	// Location of the command in the source file, unmodified commands are copied from there when dumping
+	void SetSource(const SourceSpan& source)
+	{
+		m_source = source;
+	}
+
+	const SourceSpan& GetSource() const
+	{
+		return m_source;
+	}
+
+	bool IsDirty() const
+	{
+		return m_dirty;
+	}
+
+	static void PrintArgStatistics(std::ostream& out)
+	{
+		s_intArgSizes.Print(out, "Command int arguments", IntArgs::INLINE_CAPACITY);
+		s_stringArgSizes.Print(out, "Command string arguments", StringArgs::INLINE_CAPACITY);
+		RouteCommand::ArgSizes().Print(out, "Route command arguments", RouteCommand::Args::INLINE_CAPACITY);
 	}
 
 	inline static bool s_v35 = false;
 
+private:
+	// Reads everything up to the terminator and returns the info of the class the command has to be created as
+	static const CommandInfo& readHeader(FileCoder& coder, RawCommand& raw);
+	static void readV35Trailer(FileCoder& coder, Command& cmd);
+
+protected:
+	// The setters only mark the command as modified if the value actually changes
+	void setStringArg(const std::size_t& index, const PooledString& value)
+	{
+		if (m_stringArgs[index] == value) return;
+
+		m_stringArgs[index] = value;
+		m_dirty             = true;
+	}
+
+	void setStringArgs(StringArgs&& stringArgs)
+	{
+		if (stringArgs == m_stringArgs) return;
+
+		m_stringArgs = std::move(stringArgs);
+		m_dirty      = true;
+	}
+
 protected:
-	uInts m_args;
+	IntArgs m_args;
 	CommandType m_cid;
-	tStrings m_stringArgs;
+	StringArgs m_stringArgs;
 	uint8_t m_indent;
-	Bytes m_v35Unknown;
+	ArenaBytes m_v35Unknown;
+	SourceSpan m_source = {};
+	bool m_dirty        = false;
 
 	static constexpr uint8_t TERMINATOR = 0x0;
+
+	inline static SizeHistogram s_intArgSizes    = {};
+	inline static SizeHistogram s_stringArgSizes = {};
 };
 
 namespace CommandSpecialClasses
 {
-class Picture : public Command
+class Picture final : public Command
 {
 public:
-	Picture(const CommandType& cid, const uInts& args, const tStrings& stringArgs, const uint8_t& indent) :
-		Command(cid, args, stringArgs, indent)
+	Picture(const CommandType& cid, IntArgs args, StringArgs stringArgs, const uint8_t& indent) :
+		Command(cid, std::move(args), std::move(stringArgs), indent)
 	{
 	}
 
@@ -509,9 +492,12 @@ public:
 			throw WolfRPGException(std::format("{}Picture type \"{}\" has no text", ERROR_TAG, static_cast<int32_t>(Type())));
 
 		if (m_stringArgs.empty())
+		{
 			m_stringArgs.push_back(value);
+			m_dirty = true;
+		}
 		else
-			m_stringArgs[0] = value;
+			setStringArg(0, value);
 	}
 
 	virtual const tString Filename() const
@@ -527,31 +513,32 @@ public:
 		if (Type() != PictureType::file && Type() != PictureType::windowFile)
 			throw WolfRPGException(std::format("{}Picture type \"{}\" has no filename", ERROR_TAG, static_cast<int32_t>(Type())));
 
-		m_stringArgs[0] = value;
+		setStringArg(0, value);
 	}
 };
 
-class Move : public Command
+class Move final : public Command
 {
 public:
-	Move(const CommandType& cid, const uInts& args, const tStrings& stringArgs, const uint8_t& indent, FileCoder& coder) :
-		Command(cid, args, stringArgs, indent)
+	Move(const CommandType& cid, IntArgs args, StringArgs stringArgs, const uint8_t& indent, FileCoder& coder) :
+		Command(cid, std::move(args), std::move(stringArgs), indent)
 	{
 		// Read unknown data
-		for (uint32_t i = 0; i < 5; i++)
-			m_unknown.push_back(coder.ReadByte());
+		for (uint8_t& byte : m_unknown)
+			byte = coder.ReadByte();
 		// Read known data
 		m_flags = coder.ReadByte();
 
 		// Read route
 		uint32_t routeCount = coder.ReadInt();
+		m_route.reserve(routeCount);
 		for (uint32_t i = 0; i < routeCount; i++)
 		{
 			RouteCommand rc;
 			if (!rc.Init(coder))
 				throw WolfRPGException(std::format("{}RouteCommand initialization failed at index {} of {}", ERROR_TAG, i, routeCount));
 
-			m_route.push_back(rc);
+			m_route.push_back(std::move(rc));
 		}
 	}
 
@@ -563,17 +550,17 @@ public:
 
 		coder.WriteByte(m_flags);
 		coder.WriteInt(static_cast<uint32_t>(m_route.size()));
-		for (RouteCommand cmd : m_route)
+		for (const RouteCommand& cmd : m_route)
 			cmd.Dump(coder);
 	}
 
 private:
-	Bytes m_unknown       = {};
-	uint8_t m_flags       = 0;
-	RouteCommands m_route = {};
+	std::array<uint8_t, 5> m_unknown = {};
+	uint8_t m_flags                  = 0;
+	RouteCommands m_route            = RouteCommands(Arena::Allocator());
 };
 
-class ProFeature : public Command
+class ProFeature final : public Command
 {
 public:
 	enum class Type
@@ -604,8 +591,8 @@ public:
 		9 - Vibrate gamepad
 	*/
 public:
-	ProFeature(const CommandType& cid, const uInts& args, const tStrings& stringArgs, const uint8_t& indent) :
-		Command(cid, args, stringArgs, indent)
+	ProFeature(const CommandType& cid, IntArgs args, StringArgs stringArgs, const uint8_t& indent) :
+		Command(cid, std::move(args), std::move(stringArgs), indent)
 	{
 	}
 
@@ -633,11 +620,11 @@ public:
 private:
 };
 
-class SetString : public Command
+class SetString final : public Command
 {
 public:
-	SetString(const CommandType& cid, const uInts& args, const tStrings& stringArgs, const uint8_t& indent) :
-		Command(cid, args, stringArgs, indent)
+	SetString(const CommandType& cid, IntArgs args, StringArgs stringArgs, const uint8_t& indent) :
+		Command(cid, std::move(args), std::move(stringArgs), indent)
 	{
 	}
 
@@ -663,11 +650,11 @@ public:
 	}
 };
 
-class SetVariable : public Command
+class SetVariable final : public Command
 {
 public:
-	SetVariable(const CommandType& cid, const uInts& args, const tStrings& stringArgs, const uint8_t& indent) :
-		Command(cid, args, stringArgs, indent)
+	SetVariable(const CommandType& cid, IntArgs args, StringArgs stringArgs, const uint8_t& indent) :
+		Command(cid, std::move(args), std::move(stringArgs), indent)
 	{
 	}
 
@@ -703,98 +690,515 @@ using SetString   = std::shared_ptr<CommandSpecialClasses::SetString>;
 using SetVariable = std::shared_ptr<CommandSpecialClasses::SetVariable>;
 } // namespace CommandShPtr
 
+// Commands (including their control block) are allocated from the arena of the file which is currently parsed
+template<typename T, typename... Args>
+inline std::shared_ptr<T> allocateCommand(Args&&... args)
+{
+	return std::allocate_shared<T>(Arena::Allocator<T>(), std::forward<Args>(args)...);
+}
+
+using CommandVariant = std::variant<Command, CommandSpecialClasses::Picture, CommandSpecialClasses::Move, CommandSpecialClasses::ProFeature, CommandSpecialClasses::SetString, CommandSpecialClasses::SetVariable>;
+
+template<typename T>
+inline CommandShPtr::Command createShared(RawCommand&& raw, FileCoder& coder)
+{
+	if constexpr (std::is_constructible_v<T, CommandType, IntArgs, StringArgs, uint8_t, FileCoder&>)
+		return allocateCommand<T>(raw.cid, std::move(raw.args), std::move(raw.stringArgs), raw.indent, coder);
+	else
+		return allocateCommand<T>(raw.cid, std::move(raw.args), std::move(raw.stringArgs), raw.indent);
+}
+
+template<typename T>
+inline Command& createFlat(std::pmr::vector<CommandVariant>& commands, RawCommand&& raw, FileCoder& coder)
+{
+	if constexpr (std::is_constructible_v<T, CommandType, IntArgs, StringArgs, uint8_t, FileCoder&>)
+		return std::get<T>(commands.emplace_back(std::in_place_type<T>, raw.cid, std::move(raw.args), std::move(raw.stringArgs), raw.indent, coder));
+	else
+		return std::get<T>(commands.emplace_back(std::in_place_type<T>, raw.cid, std::move(raw.args), std::move(raw.stringArgs), raw.indent));
+}
+
+// Everything that is known about a command type: the name used in the JSON export,
+// the class it is created as and which string arguments contain translatable text
+struct CommandInfo
+{
+	using SharedFactory = CommandShPtr::Command (*)(RawCommand&&, FileCoder&);
+	using FlatFactory   = Command& (*)(std::pmr::vector<CommandVariant>&, RawCommand&&, FileCoder&);
+
+	CommandType type;
+	std::string_view name;
+	SharedFactory createShared;
+	FlatFactory createFlat;
+	uint8_t firstText;
+	uint8_t textCount;
+};
+
+static constexpr uint8_t ALL_TEXTS = 0xFF;
+
+template<typename T = Command>
+constexpr CommandInfo commandInfo(const CommandType& type, const std::string_view& name, const uint8_t& firstText = 0, const uint8_t& textCount = 0)
+{
+	return { type, name, &createShared<T>, &createFlat<T>, firstText, textCount };
+}
+
+inline constexpr std::array COMMAND_INFOS = {
+	commandInfo(CommandType::Default, "Command"),
+	commandInfo(CommandType::Blank, "Blank"),
+	commandInfo(CommandType::Checkpoint, "Checkpoint"),
+	commandInfo(CommandType::Message, "Message", 0, 1),
+	commandInfo(CommandType::Choices, "Choices", 0, ALL_TEXTS),
+	commandInfo(CommandType::Comment, "Comment"),
+	commandInfo(CommandType::ForceStopMessage, "ForceStopMessage"),
+	commandInfo(CommandType::DebugMessage, "DebugMessage"),
+	commandInfo(CommandType::ClearDebugText, "ClearDebugText"),
+	commandInfo(CommandType::VariableCondition, "VariableCondition"),
+	commandInfo(CommandType::StringCondition, "StringCondition", 0, ALL_TEXTS),
+	commandInfo<CommandSpecialClasses::SetVariable>(CommandType::SetVariable, "SetVariable"),
+	commandInfo<CommandSpecialClasses::SetString>(CommandType::SetString, "SetString", 0, 1),
+	commandInfo(CommandType::InputKey, "InputKey"),
+	commandInfo(CommandType::SetVariableEx, "SetVariableEx"),
+	commandInfo(CommandType::AutoInput, "AutoInput"),
+	commandInfo(CommandType::BanInput, "BanInput"),
+	commandInfo(CommandType::Teleport, "Teleport"),
+	commandInfo(CommandType::Sound, "Sound"),
+	commandInfo<CommandSpecialClasses::Picture>(CommandType::Picture, "Picture", 0, 1),
+	commandInfo(CommandType::ChangeColor, "ChangeColor"),
+	commandInfo(CommandType::SetTransition, "SetTransition"),
+	commandInfo(CommandType::PrepareTransition, "PrepareTransition"),
+	commandInfo(CommandType::ExecuteTransition, "ExecuteTransition"),
+	commandInfo(CommandType::StartLoop, "StartLoop"),
+	commandInfo(CommandType::BreakLoop, "BreakLoop"),
+	commandInfo(CommandType::BreakEvent, "BreakEvent"),
+	commandInfo(CommandType::EraseEvent, "EraseEvent"),
+	commandInfo(CommandType::ReturnToTitle, "ReturnToTitle"),
+	commandInfo(CommandType::EndGame, "EndGame"),
+	commandInfo(CommandType::StartLoop2, "StartLoop"),
+	commandInfo(CommandType::StopNonPic, "StopNonPic"),
+	commandInfo(CommandType::ResumeNonPic, "ResumeNonPic"),
+	commandInfo(CommandType::LoopTimes, "LoopTimes"),
+	commandInfo(CommandType::Wait, "Wait"),
+	commandInfo<CommandSpecialClasses::Move>(CommandType::Move, "Move"),
+	commandInfo(CommandType::WaitForMove, "WaitForMove"),
+	commandInfo(CommandType::CommonEvent, "CommonEvent"),
+	commandInfo(CommandType::CommonEventReserve, "CommonEventReserve"),
+	commandInfo(CommandType::SetLabel, "SetLabel"),
+	commandInfo(CommandType::JumpLabel, "JumpLabel"),
+	commandInfo(CommandType::SaveLoad, "SaveLoad"),
+	commandInfo(CommandType::LoadGame, "LoadGame"),
+	commandInfo(CommandType::SaveGame, "SaveGame"),
+	commandInfo(CommandType::MoveDuringEventOn, "MoveDuringEventOn"),
+	commandInfo(CommandType::MoveDuringEventOff, "MoveDuringEventOff"),
+	commandInfo(CommandType::Chip, "Chip"),
+	commandInfo(CommandType::ChipSet, "ChipSet"),
+	commandInfo(CommandType::Database, "Database", 0, 1),
+	commandInfo(CommandType::ImportDatabase, "ImportDatabase"),
+	commandInfo(CommandType::Party, "Party"),
+	commandInfo(CommandType::MapEffect, "MapEffect"),
+	commandInfo(CommandType::ScrollScreen, "ScrollScreen"),
+	commandInfo(CommandType::Effect, "Effect"),
+	commandInfo(CommandType::CommonEventByName, "CommonEventByName", 1, 3),
+	commandInfo(CommandType::ChoiceCase, "ChoiceCase"),
+	commandInfo(CommandType::SpecialChoiceCase, "SpecialChoiceCase"),
+	commandInfo(CommandType::ElseCase, "ElseCase"),
+	commandInfo(CommandType::CancelCase, "CancelCase"),
+	commandInfo(CommandType::LoopEnd, "LoopEnd"),
+	commandInfo(CommandType::BranchEnd, "BranchEnd"),
+	// Exported with the generic name, existing dumps refer to it as "Command"
+	commandInfo<CommandSpecialClasses::ProFeature>(CommandType::ProFeature, "Command"),
+};
+
+// Maps every command ID to its entry in COMMAND_INFOS, unknown IDs map to the default entry
+inline constexpr std::array COMMAND_INFO_INDEX = []() {
+	std::array<uint8_t, static_cast<std::size_t>(CommandType::ProFeature) + 1> index = {};
+
+	for (std::size_t i = 0; i < COMMAND_INFOS.size(); i++)
+		index[static_cast<std::size_t>(COMMAND_INFOS[i].type)] = static_cast<uint8_t>(i);
+
+	return index;
+}();
+
+static_assert(COMMAND_INFOS.size() <= 0xFF, "COMMAND_INFO_INDEX entries are 8 bit");
+
+constexpr const CommandInfo& GetCommandInfo(const CommandType& type)
+{
+	const std::size_t id = static_cast<std::size_t>(static_cast<uint32_t>(type));
+
+	if (id >= COMMAND_INFO_INDEX.size())
+		return COMMAND_INFOS[0];
+
+	return COMMAND_INFOS[COMMAND_INFO_INDEX[id]];
+}
+
+inline std::string_view Command::Command::GetClassName() const
+{
+	return GetCommandInfo(m_cid).name;
+}
+
 inline CommandShPtr::Command Command::Command::Init(FileCoder& coder)
 {
-	CommandShPtr::Command cmd = nullptr;
-	uint8_t argsCount         = coder.ReadByte() - 1;
-	CommandType cid           = static_cast<CommandType>(coder.ReadInt());
-	uInts args;
+	RawCommand raw;
+	CommandShPtr::Command cmd = readHeader(coder, raw).createShared(std::move(raw), coder);
+	readV35Trailer(coder, *cmd);
 
-	for (uint8_t i = 0; i < argsCount; i++)
-		args.push_back(coder.ReadInt());
+	return cmd;
+}
 
-	uint8_t indent = coder.ReadByte();
-	argsCount      = coder.ReadByte();
+inline void Command::Command::Skip(FileCoder& coder)
+{
+	const uint8_t argsCount = coder.ReadByte() - 1;
+	coder.Skip(4 + argsCount * 4 + 1); // Command ID, arguments and indent
 
-	tStrings stringArgs;
+	const uint8_t stringCount = coder.ReadByte();
+	for (uint8_t i = 0; i < stringCount; i++)
+		coder.SkipString();
 
+	const uint8_t terminator = coder.ReadByte();
+	if (terminator == 0x01)
+	{
+		// Move commands, unknown data and flags (see Move) followed by the route
+		coder.Skip(5 + 1);
+
+		const uint32_t routeCount = coder.ReadInt();
+		for (uint32_t i = 0; i < routeCount; i++)
+			RouteCommand::Skip(coder);
+	}
+	else if (terminator != TERMINATOR)
+		throw WolfRPGException(std::format("{}Unexpected command terminator: {:#02x} (expected {:#02x} or 0x01)", ERROR_TAG, terminator, TERMINATOR));
+
+	if (s_v35)
+		coder.Skip(coder.ReadByte());
+}
+
+inline const CommandInfo& Command::Command::readHeader(FileCoder& coder, RawCommand& raw)
+{
+	uint8_t argsCount = coder.ReadByte() - 1;
+	raw.cid           = static_cast<CommandType>(coder.ReadInt());
+
+	raw.args.reserve(argsCount);
 	for (uint8_t i = 0; i < argsCount; i++)
-		stringArgs.push_back(coder.ReadString());
+		raw.args.push_back(coder.ReadInt());
+
+	raw.indent = coder.ReadByte();
+	argsCount  = coder.ReadByte();
+
+	raw.stringArgs.reserve(argsCount);
+	for (uint8_t i = 0; i < argsCount; i++)
+		raw.stringArgs.push_back(coder.ReadPooledString());
+
+	s_intArgSizes.Record(raw.args.size());
+	s_stringArgSizes.Record(raw.stringArgs.size());
 
 	uint8_t terminator = coder.ReadByte();
 	if (terminator == 0x01)
-		cmd = std::make_shared<CommandSpecialClasses::Move>(cid, args, stringArgs, indent, coder);
+		return GetCommandInfo(CommandType::Move);
 	else if (terminator != TERMINATOR)
 		throw WolfRPGException(std::format("{}Unexpected command terminator: {:#02x} (expected {:#02x} or 0x01)", ERROR_TAG, terminator, TERMINATOR));
-	else
-	{
-		switch (cid)
-		{
-			case CommandType::Picture:
-				cmd = std::make_shared<CommandSpecialClasses::Picture>(cid, args, stringArgs, indent);
-				break;
-			case CommandType::Move:
-				cmd = std::make_shared<CommandSpecialClasses::Move>(cid, args, stringArgs, indent, coder);
-				break;
-			case CommandType::ProFeature:
-				cmd = std::make_shared<CommandSpecialClasses::ProFeature>(cid, args, stringArgs, indent);
-				break;
-			case CommandType::SetString:
-				cmd = std::make_shared<CommandSpecialClasses::SetString>(cid, args, stringArgs, indent);
-				break;
-			case CommandType::SetVariable:
-				cmd = std::make_shared<CommandSpecialClasses::SetVariable>(cid, args, stringArgs, indent);
-				break;
-			default:
-				cmd = std::make_shared<Command>(cid, args, stringArgs, indent);
-				break;
-		}
-	}
 
+	return GetCommandInfo(raw.cid);
+}
+
+inline void Command::Command::readV35Trailer(FileCoder& coder, Command& cmd)
+{
 	if (s_v35)
 	{
 		uint8_t unknownSize = coder.ReadByte();
 
-		Bytes v35Unknown = {};
-
 		if (unknownSize > 0)
-			v35Unknown = coder.Read(unknownSize);
-
-		cmd->SetV35Unknown(v35Unknown);
+			coder.Read(cmd.m_v35Unknown, unknownSize);
 	}
+}
 
-	return cmd;
+// Range [first, last) of the string arguments which contain translatable text
+static std::pair<std::size_t, std::size_t> textRange(const Command& command)
+{
+	if (!command.Valid()) return { 0, 0 };
+
+	if (command.GetType() == CommandType::Picture && command.Type() != PictureType::text)
+		return { 0, 0 };
+
+	const CommandInfo& info = GetCommandInfo(command.GetType());
+	const std::size_t size  = command.Texts().size();
+
+	if (info.firstText >= size) return { 0, 0 };
+
+	return { info.firstText, std::min<std::size_t>(size, info.firstText + info.textCount) };
 }
 
-static const tStrings stringsOfCommand(const CommandShPtr::Command& command)
+static const tStrings stringsOfCommand(const Command& command)
 {
 	tStrings strs = tStrings();
-	if (!command->Valid()) return strs;
-
-	switch (command->GetType())
-	{
-		case CommandType::Message:
-		case CommandType::SetString:
-		case CommandType::Database:
-			strs.push_back(command->Text());
-			break;
-		case CommandType::Choices:
-		case CommandType::StringCondition:
-			return command->Texts();
-		case CommandType::Picture:
-			if (command->Type() == PictureType::text)
-				strs.push_back(command->Text());
-			break;
-		case CommandType::CommonEventByName:
-			for (size_t i = 1; i <= 3; i++)
-				strs.push_back(command->Texts().at(i));
-			break;
-		default:
-			break;
-	}
+
+	const auto [first, last] = textRange(command);
+	const StringArgs& texts  = command.Texts();
+
+	for (std::size_t i = first; i < last; i++)
+		strs.push_back(texts[i]);
 
 	return strs;
 }
 
-using Commands = std::vector<CommandShPtr::Command>;
+static const tStrings stringsOfCommand(const CommandShPtr::Command& command)
+{
+	return stringsOfCommand(*command);
+}
+
+// Commands of a page or common event.
+// By default every command is a separate shared object. With flat storage enabled the commands are
+// stored by value in one contiguous vector and the calls are dispatched statically on the concrete type.
+class Commands
+{
+public:
+	using Variant = CommandVariant;
+
+	Commands() :
+		m_shared(Arena::Allocator()),
+		m_flat(Arena::Allocator()),
+		m_isFlat(s_flatStorage)
+	{
+	}
+
+	// Only affects command lists created afterwards
+	static void SetFlatStorage(const bool& flat)
+	{
+		s_flatStorage = flat;
+	}
+
+	void Reserve(const std::size_t& count)
+	{
+		if (m_isFlat)
+			m_flat.reserve(count);
+		else
+			m_shared.reserve(count);
+	}
+
+	// Reads the next command from the coder and appends it
+	const Command& Read(FileCoder& coder)
+	{
+		const uint8_t* pStart = coder.CurrentData();
+		Command* pCmd         = nullptr;
+
+		if (!m_isFlat)
+		{
+			m_shared.push_back(Command::Init(coder));
+			pCmd = m_shared.back().get();
+		}
+		else
+		{
+			RawCommand raw;
+			pCmd = &Command::readHeader(coder, raw).createFlat(m_flat, std::move(raw), coder);
+			Command::readV35Trailer(coder, *pCmd);
+		}
+
+		pCmd->SetSource(coder.SpanFrom(pStart));
+
+		return *pCmd;
+	}
+
+	// Moves the coder behind a command list without parsing it
+	static void Skip(FileCoder& coder)
+	{
+		const uint32_t count = coder.ReadInt();
+		for (uint32_t i = 0; i < count; i++)
+			Command::Skip(coder);
+	}
+
+	std::size_t size() const
+	{
+		return m_isFlat ? m_flat.size() : m_shared.size();
+	}
+
+	bool empty() const
+	{
+		return (size() == 0);
+	}
+
+	// Calls func with the command at index, in flat storage with its concrete type
+	template<typename Func>
+	decltype(auto) Visit(const std::size_t& index, Func&& func) const
+	{
+		if (m_isFlat)
+			return std::visit(std::forward<Func>(func), m_flat.at(index));
+
+		return func(static_cast<const Command&>(*m_shared.at(index)));
+	}
+
+	template<typename Func>
+	decltype(auto) Visit(const std::size_t& index, Func&& func)
+	{
+		if (m_isFlat)
+			return std::visit(std::forward<Func>(func), m_flat.at(index));
+
+		return func(static_cast<Command&>(*m_shared.at(index)));
+	}
+
+	const Command& operator[](const std::size_t& index) const
+	{
+		return Visit(index, [](const Command& cmd) -> const Command& { return cmd; });
+	}
+
+	Command& operator[](const std::size_t& index)
+	{
+		return Visit(index, [](Command& cmd) -> Command& { return cmd; });
+	}
+
+	template<typename Func>
+	void ForEach(Func&& func) const
+	{
+		if (m_isFlat)
+		{
+			for (const Variant& var : m_flat)
+				std::visit(func, var);
+			return;
+		}
+
+		for (const CommandShPtr::Command& cmd : m_shared)
+			func(static_cast<const Command&>(*cmd));
+	}
+
+	// The qualified calls below bypass the vtable, the variant already knows the concrete type
+	// Writes the commands as JSON array
+	void WriteJson(JsonWriter& writer) const
+	{
+		writer.BeginArray();
+
+		if (m_isFlat)
+		{
+			for (std::size_t i = 0; i < m_flat.size(); i++)
+				std::visit([&]<typename T>(const T& cmd) { cmd.T::WriteJson(writer, i); }, m_flat[i]);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < m_shared.size(); i++)
+				m_shared[i]->WriteJson(writer, i);
+		}
+
+		writer.EndArray();
+	}
+
+	// Returns true if the command differs from its source after patching
+	bool Patch(const std::size_t& index, const nlohmann::ordered_json& j)
+	{
+		if (!m_isFlat)
+		{
+			Command& cmd = *m_shared.at(index);
+			cmd.Patch(j);
+			return cmd.IsDirty();
+		}
+
+		return std::visit([&]<typename T>(T& cmd) { cmd.T::Patch(j); return cmd.IsDirty(); }, m_flat.at(index));
+	}
+
+	// Patches a single command addressed by an entry of a sparse patch (see SparsePatch.hpp).
+	// The code of the entry has to match the command, i.e., entries created for a different version of the game are rejected.
+	bool PatchEntry(const nlohmann::ordered_json& j)
+	{
+		CHECK_JSON_KEY(j, "index", "command");
+		CHECK_JSON_KEY(j, "code", "command");
+
+		const uint32_t index = j["index"].get<uint32_t>();
+		if (index >= size())
+			throw WolfRPGException(std::format("{}Command index out of range in patch (index: {}, command count: {})", ERROR_TAG, index, size()));
+
+		const int32_t code     = j["code"].get<int32_t>();
+		const int32_t expected = static_cast<int32_t>((*this)[index].GetType());
+		if (code != expected)
+			throw WolfRPGException(std::format("{}Command code mismatch at index {} (expected {}, got {})", ERROR_TAG, index, expected, code));
+
+		return Patch(index, j);
+	}
+
+	// Adds the texts of the commands to the table (see TextTable.hpp), keyed by prefix/command index/argument index
+	void ExportTexts(TextTable& table, const std::string& prefix) const
+	{
+		for (std::size_t i = 0; i < size(); i++)
+		{
+			const Command& cmd       = (*this)[i];
+			const auto [first, last] = textRange(cmd);
+
+			for (std::size_t arg = first; arg < last; arg++)
+				table.Add(std::format("{}/{}/{}", prefix, i, arg), cmd.Texts()[arg]);
+		}
+	}
+
+	// Returns true if a command differs from its source after applying the table
+	bool ApplyTexts(const TextTable& table, const std::string& prefix)
+	{
+		bool modified = false;
+
+		for (std::size_t i = 0; i < size(); i++)
+		{
+			Command& cmd             = (*this)[i];
+			const auto [first, last] = textRange(cmd);
+
+			for (std::size_t arg = first; arg < last; arg++)
+			{
+				const std::string* pText = table.Find(std::format("{}/{}/{}", prefix, i, arg));
+				if (pText == nullptr) continue;
+
+				cmd.SetText(ToUTF16(*pText), static_cast<uint32_t>(arg));
+				modified |= cmd.IsDirty();
+			}
+		}
+
+		return modified;
+	}
+
+	// Unmodified commands are copied from the source data, only modified ones are encoded again.
+	// Unmodified commands which are adjacent in the source are written with a single copy.
+	void Dump(FileCoder& coder) const
+	{
+		coder.WriteInt(static_cast<uint32_t>(size()));
+
+		SourceSpan run = {};
+
+		for (std::size_t i = 0; i < size(); i++)
+		{
+			const Command& cmd = (*this)[i];
+
+			if (!cmd.IsDirty() && cmd.GetSource().Valid())
+			{
+				if (run.Valid() && run.End() == cmd.GetSource().pData)
+					run.size += cmd.GetSource().size;
+				else
+				{
+					if (run.Valid())
+						coder.Write(run);
+					run = cmd.GetSource();
+				}
+
+				continue;
+			}
+
+			if (run.Valid())
+				coder.Write(run);
+			run = {};
+
+			dumpCommand(i, coder);
+		}
+
+		if (run.Valid())
+			coder.Write(run);
+	}
+
+private:
+	void dumpCommand(const std::size_t& index, FileCoder& coder) const
+	{
+		if (!m_isFlat)
+			return m_shared[index]->Dump(coder);
+
+		const auto dump = [&]<typename T>(const T& cmd) {
+			cmd.DumpData(coder);
+			cmd.T::DumpTerminator(coder);
+			cmd.DumpV35Trailer(coder);
+		};
+
+		std::visit(dump, m_flat[index]);
+	}
+
+private:
+	std::pmr::vector<CommandShPtr::Command> m_shared;
+	std::pmr::vector<Variant> m_flat;
+	bool m_isFlat;
+
+	inline static bool s_flatStorage = false;
+};
 } // namespace Command
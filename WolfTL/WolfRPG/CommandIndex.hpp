@@ -0,0 +1,194 @@
+/*
+ *  File: CommandIndex.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include "Command.hpp"
+#include "CommonEvents.hpp"
+#include "Map.hpp"
+#include "WolfRPGException.hpp"
+#include "WolfRPGUtils.hpp"
+
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <vector>
+
+// Every command of the maps and common events in struct-of-arrays form.
+// Entry i of every column describes the same command, the commands of the maps come first (ordered by map, event, page and index),
+// followed by the commands of the common events. Filters only scan the columns they need, e.g., finding all commands
+// of a type compares one contiguous array instead of walking the command lists of every page.
+class CommandIndex
+{
+public:
+	// Value of the file column for the commands of common events
+	static constexpr uint32_t COMMON_EVENT = std::numeric_limits<uint32_t>::max();
+
+	using Positions = std::vector<std::size_t>;
+
+	CommandIndex() = default;
+
+	CommandIndex(const Maps& maps, const CommonEvents& commonEvents)
+	{
+		for (std::size_t i = 0; i < maps.size(); i++)
+		{
+			for (const Event& ev : maps[i].GetEvents())
+			{
+				for (const Page& page : ev.GetPages())
+					add(page.GetCommands(), static_cast<uint32_t>(i), ev.GetID(), page.GetID());
+			}
+		}
+
+		for (const CommonEvent& ev : commonEvents.GetEvents())
+			add(ev.GetCommands(), COMMON_EVENT, ev.GetID(), 0);
+	}
+
+	std::size_t Size() const
+	{
+		return m_types.size();
+	}
+
+	// Positions of all commands of the given type, optionally only the ones with string arguments
+	Positions Select(const Command::CommandType& type, const bool& withStrings = false) const
+	{
+		Positions positions;
+
+		for (std::size_t i = 0; i < m_types.size(); i++)
+		{
+			if (m_types[i] == type && (!withStrings || m_hasStrings[i]))
+				positions.push_back(i);
+		}
+
+		return positions;
+	}
+
+	std::size_t Count(const Command::CommandType& type, const bool& withStrings = false) const
+	{
+		std::size_t count = 0;
+
+		// Branchless, so the loop can be vectorized
+		for (std::size_t i = 0; i < m_types.size(); i++)
+			count += static_cast<std::size_t>((m_types[i] == type) & (!withStrings | (m_hasStrings[i] != 0)));
+
+		return count;
+	}
+
+	// The command at a position of the index, maps and commonEvents have to be the ones the index was built from
+	const Command::Command& Get(const std::size_t& pos, const Maps& maps, const CommonEvents& commonEvents) const
+	{
+		if (pos >= m_types.size())
+			throw WolfRPGException(std::format("{}Command index position out of range (position: {}, size: {})", ERROR_TAG, pos, m_types.size()));
+
+		if (m_files[pos] == COMMON_EVENT)
+		{
+			const CommonEvent* pEvent = commonEvents.FindEvent(m_events[pos]);
+			if (pEvent == nullptr)
+				throw WolfRPGException(std::format("{}Common event {} of the command index not found", ERROR_TAG, m_events[pos]));
+
+			return command(pEvent->GetCommands(), pos);
+		}
+
+		const Event* pEvent = maps.at(m_files[pos]).FindEvent(m_events[pos]);
+		if (pEvent == nullptr)
+			throw WolfRPGException(std::format("{}Event {} of the command index not found", ERROR_TAG, m_events[pos]));
+
+		return command(pEvent->GetPages().at(m_pages[pos]).GetCommands(), pos);
+	}
+
+	const std::vector<Command::CommandType>& GetTypes() const
+	{
+		return m_types;
+	}
+
+	const std::vector<uint8_t>& GetIndents() const
+	{
+		return m_indents;
+	}
+
+	// Index of the map in the list of maps or COMMON_EVENT
+	const std::vector<uint32_t>& GetFiles() const
+	{
+		return m_files;
+	}
+
+	// ID of the event or common event
+	const std::vector<uint32_t>& GetEvents() const
+	{
+		return m_events;
+	}
+
+	// Page of the event, always 0 for common events
+	const std::vector<uint32_t>& GetPages() const
+	{
+		return m_pages;
+	}
+
+	// Index of the command in the page or common event
+	const std::vector<uint32_t>& GetCommands() const
+	{
+		return m_commands;
+	}
+
+	// 1 if the command has string arguments, 0 otherwise
+	const std::vector<uint8_t>& GetHasStrings() const
+	{
+		return m_hasStrings;
+	}
+
+private:
+	// Rejects positions which no longer match the commands, i.e., the commands were modified after the index was built
+	const Command::Command& command(const Command::Commands& commands, const std::size_t& pos) const
+	{
+		if (m_commands[pos] >= commands.size() || commands[m_commands[pos]].GetType() != m_types[pos])
+			throw WolfRPGException(std::format("{}Command index is outdated (position: {})", ERROR_TAG, pos));
+
+		return commands[m_commands[pos]];
+	}
+
+	void add(const Command::Commands& commands, const uint32_t& file, const uint32_t& event, const uint32_t& page)
+	{
+		uint32_t index = 0;
+
+		commands.ForEach([&](const Command::Command& cmd) {
+			m_types.push_back(cmd.GetType());
+			m_indents.push_back(cmd.GetIndent());
+			m_files.push_back(file);
+			m_events.push_back(event);
+			m_pages.push_back(page);
+			m_commands.push_back(index++);
+			m_hasStrings.push_back(cmd.Texts().empty() ? 0 : 1);
+		});
+	}
+
+private:
+	std::vector<Command::CommandType> m_types = {};
+	std::vector<uint8_t> m_indents            = {};
+	std::vector<uint32_t> m_files             = {};
+	std::vector<uint32_t> m_events            = {};
+	std::vector<uint32_t> m_pages             = {};
+	std::vector<uint32_t> m_commands          = {};
+	std::vector<uint8_t> m_hasStrings         = {};
+};
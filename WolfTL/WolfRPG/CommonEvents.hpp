@@ -28,6 +28,9 @@
 
 #include "Command.hpp"
 #include "FileCoder.hpp"
+#include "JsonStream.hpp"
+#include "LazyIndex.hpp"
+#include "Schema.hpp"
 #include "WolfDataBase.hpp"
 #include "WolfRPGUtils.hpp"
 
@@ -35,6 +38,7 @@
 #include <format>
 #include <fstream>
 #include <nlohmann/json.hpp>
+#include <optional>
 
 class CommonEvent
 {
@@ -48,94 +52,36 @@ public:
 
 	explicit CommonEvent(FileCoder& coder, const uint32_t& id) :
 		m_id(id),
-		m_valid(false),
-		m_unknown10Valid(false)
+		m_valid(false)
 	{
 		m_valid = init(coder);
 	}
 
 	void Dump(FileCoder& coder) const
 	{
-		coder.WriteByte(0x8E);
-		coder.WriteInt(m_intId);
-		coder.WriteInt(m_unknown1);
-		coder.Write(m_unknown2);
-		coder.WriteString(m_name);
-		coder.WriteInt(m_commands.size());
-
-		for (const Command::CommandShPtr::Command& cmd : m_commands)
-			cmd->Dump(coder);
-
-		coder.WriteString(m_unknown11);
-		coder.WriteString(m_description);
-		coder.WriteByte(0x8F);
-		coder.WriteInt(static_cast<uint32_t>(m_unknown3.size()));
+		Head::Write(coder, *this);
+		m_commands.Dump(coder);
 
-		for (const tString& str : m_unknown3)
-			coder.WriteString(str);
+		Description::Write(coder, *this);
+		coder.Write(m_unknownBlock);
 
-		coder.WriteInt(static_cast<uint32_t>(m_unknown4.size()));
-		for (const uint8_t& byte : m_unknown4)
-			coder.WriteByte(byte);
-
-		coder.WriteInt(static_cast<uint32_t>(m_unknown5.size()));
-		for (const tStrings& strs : m_unknown5)
-		{
-			coder.WriteInt(strs.size());
-			for (const tString& str : strs)
-				coder.WriteString(str);
-		}
-
-		coder.WriteInt(static_cast<uint32_t>(m_unknown6.size()));
-		for (const uInts& uints : m_unknown6)
-		{
-			coder.WriteInt(uints.size());
-			for (const uint32_t& uint : uints)
-				coder.WriteInt(uint);
-		}
-
-		coder.Write(m_unknown7);
-		for (const tString& str : m_unknown8)
-			coder.WriteString(str);
-
-		coder.WriteByte(0x91);
-		coder.WriteString(m_unknown9);
-
-		if (m_unknown10Valid)
-		{
-			coder.WriteByte(0x92);
-			coder.WriteString(m_unknown10);
-			coder.WriteInt(m_unknown12);
-			coder.WriteByte(0x92);
-		}
-		else
-			coder.WriteByte(0x91);
+		Tail::Write(coder, *this);
 	}
 
-	nlohmann::ordered_json ToJson() const
+	void WriteJson(JsonWriter& writer) const
 	{
-		nlohmann::ordered_json j;
+		writer.BeginObject();
+		writer.Value("id", m_intId);
+		writer.Value("name", ToUTF8(m_name));
+		writer.Value("description", ToUTF8(m_description));
 
-		j["id"]          = m_intId;
-		j["name"]        = ToUTF8(m_name);
-		j["description"] = ToUTF8(m_description);
-		j["commands"]    = nlohmann::ordered_json::array();
-
-		for (std::size_t i = 0; i < m_commands.size(); i++)
-		{
-			nlohmann::ordered_json cmdJ = m_commands[i]->ToJson();
+		writer.Key("commands");
+		m_commands.WriteJson(writer);
 
-			if (!cmdJ.empty())
-			{
-				cmdJ["index"] = i;
-				j["commands"].push_back(cmdJ);
-			}
-		}
-
-		return j;
+		writer.EndObject();
 	}
 
-	void Patch(const nlohmann::ordered_json& j)
+	bool Patch(const nlohmann::ordered_json& j)
 	{
 		CHECK_JSON_KEY(j, "id", "CommonEvent");
 
@@ -148,8 +94,8 @@ public:
 		CHECK_JSON_KEY(j, "description", "CommonEvent");
 		CHECK_JSON_KEY(j, "commands", "CommonEvent");
 
-		m_name        = ToUTF16(j["name"].get<std::string>());
-		m_description = ToUTF16(j["description"].get<std::string>());
+		bool modified = UpdateValue(m_name, ToUTF16(j["name"].get<std::string>()));
+		modified |= UpdateValue(m_description, ToUTF16(j["description"].get<std::string>()));
 
 		uint32_t cmdIdx = 0;
 
@@ -162,16 +108,50 @@ public:
 			if (index >= m_commands.size())
 				throw WolfRPGException(std::format("{}Command index out of range in patch (index {}, commands count {})", ERROR_TAG, index, m_commands.size()));
 
-			m_commands[index]->Patch(cmdJ);
+			modified |= m_commands.Patch(index, cmdJ);
 		}
+
+		return modified;
 	}
 
-	void FixPro35Description()
+	// Returns true if the description contained characters which had to be removed
+	bool FixPro35Description()
 	{
+		const std::size_t oldSize = m_description.size();
+
 		// Remove all Ascii characters < 0x20 from the description
 		m_description.erase(std::remove_if(m_description.begin(), m_description.end(),
 										   [](const wchar_t& c) { return c < 0x20 && c != 0x0A && c != 0x0D; }),
 							m_description.end());
+
+		return (m_description.size() != oldSize);
+	}
+
+	// Entry of a sparse patch, addresses either a command (by its index) or the name and description
+	bool PatchEntry(const nlohmann::ordered_json& j)
+	{
+		if (j.contains("index"))
+			return m_commands.PatchEntry(j);
+
+		bool modified = false;
+
+		if (j.contains("name"))
+			modified |= UpdateValue(m_name, ToUTF16(j["name"].get<std::string>()));
+
+		if (j.contains("description"))
+			modified |= UpdateValue(m_description, ToUTF16(j["description"].get<std::string>()));
+
+		return modified;
+	}
+
+	void ExportTexts(TextTable& table, const std::string& prefix) const
+	{
+		m_commands.ExportTexts(table, prefix);
+	}
+
+	bool ApplyTexts(const TextTable& table, const std::string& prefix)
+	{
+		return m_commands.ApplyTexts(table, prefix);
 	}
 
 	const bool& IsValid() const
@@ -199,86 +179,96 @@ public:
 		return m_commands;
 	}
 
-private:
-	bool init(FileCoder& coder)
+	// Moves the coder behind the common event without parsing it, has to follow the layout read by init
+	static void Skip(FileCoder& coder)
 	{
 		uint8_t indicator = coder.ReadByte();
 		if (indicator != 0x8E)
 			throw WolfRPGException(std::format("{}CommonEvent header indicator not 0x8E (got {:#02x})", ERROR_TAG, indicator));
 
-		m_intId = coder.ReadInt();
+		coder.Skip(4 + 4 + 7); // ID and unknown data
+		coder.SkipString();
 
-		m_unknown1 = coder.ReadInt();
-		m_unknown2 = coder.Read(7);
-		m_name     = coder.ReadString();
+		Command::Commands::Skip(coder);
 
-		uint32_t commandCnt = coder.ReadInt();
-		for (uint32_t i = 0; i < commandCnt; i++)
-		{
-			Command::CommandShPtr::Command command = Command::Command::Init(coder);
+		coder.SkipString();
+		coder.SkipString();
 
-			if (!command->Valid())
-				throw WolfRPGException(std::format("{}Initialization of Command #{} in CommonEvent #{} failed", ERROR_TAG, i, m_id));
+		indicator = coder.ReadByte();
+		if (indicator != 0x8F)
+			throw WolfRPGException(std::format("{}CommonEvent data indicator not 0x8F (got {:#02x})", ERROR_TAG, indicator));
 
-			m_commands.push_back(command);
-		}
+		skipUnknownBlock(coder);
+
+		indicator = coder.ReadByte();
+		if (indicator != END_INDICATOR)
+			throw WolfRPGException(std::format("{}CommonEvent data indicator not 0x91 (got {:#02x})", ERROR_TAG, indicator));
 
-		m_unknown11   = coder.ReadString();
-		m_description = coder.ReadString();
+		coder.SkipString();
 
 		indicator = coder.ReadByte();
-		if (indicator != 0x8F)
-			throw WolfRPGException(std::format("{}CommonEvent data indicator not 0x8F (got {:#02x})", ERROR_TAG, indicator));
+		if (indicator == END_INDICATOR) return;
+		if (indicator != EXTENSION_INDICATOR)
+			throw WolfRPGException(std::format("{}CommonEvent data indicator not 0x92 or 0x91 (got {:#02x})", ERROR_TAG, indicator));
 
-		m_unknown3.resize(coder.ReadInt());
-		for (tString& str : m_unknown3)
-			str = coder.ReadString();
+		coder.SkipString();
+		coder.Skip(4);
 
-		m_unknown4.resize(coder.ReadInt());
-		for (uint8_t& byte : m_unknown4)
-			byte = coder.ReadByte();
+		indicator = coder.ReadByte();
+		if (indicator != EXTENSION_INDICATOR)
+			throw WolfRPGException(std::format("{}CommonEvent data indicator not 0x92 (got {:#02x})", ERROR_TAG, indicator));
+	}
 
-		m_unknown5.resize(coder.ReadInt());
-		for (tStrings& strs : m_unknown5)
-		{
-			strs = tStrings(coder.ReadInt());
-			for (tString& str : strs)
-				str = coder.ReadString();
-		}
+private:
+	// Moves the coder behind the unknown data following the description, the data is never modified,
+	// therefore, it is only walked to find its end and copied from the source when dumping
+	static void skipUnknownBlock(FileCoder& coder)
+	{
+		uint32_t count = coder.ReadInt();
+		for (uint32_t i = 0; i < count; i++)
+			coder.SkipString();
 
-		m_unknown6.resize(coder.ReadInt());
-		for (uInts& uints : m_unknown6)
+		coder.Skip(coder.ReadInt());
+
+		count = coder.ReadInt();
+		for (uint32_t i = 0; i < count; i++)
 		{
-			uints = uInts(coder.ReadInt());
-			for (uint32_t& uint : uints)
-				uint = coder.ReadInt();
+			const uint32_t strCount = coder.ReadInt();
+			for (uint32_t j = 0; j < strCount; j++)
+				coder.SkipString();
 		}
 
-		m_unknown7 = coder.Read(0x1D);
-		for (tString& str : m_unknown8)
-			str = coder.ReadString();
+		count = coder.ReadInt();
+		for (uint32_t i = 0; i < count; i++)
+			coder.Skip(coder.ReadInt() * 4);
 
-		indicator = coder.ReadByte();
-		if (indicator != 0x91)
-			throw WolfRPGException(std::format("{}CommonEvent data indicator not 0x91 (got {:#02x})", ERROR_TAG, indicator));
+		coder.Skip(0x1D);
+		for (uint32_t i = 0; i < UNKNOWN_STRING_COUNT; i++)
+			coder.SkipString();
+	}
 
-		m_unknown9 = coder.ReadString();
+	bool init(FileCoder& coder)
+	{
+		Head::Read(coder, *this);
 
-		indicator = coder.ReadByte();
-		if (indicator != 0x92)
+		uint32_t commandCnt = coder.ReadInt();
+		m_commands.Reserve(commandCnt);
+		for (uint32_t i = 0; i < commandCnt; i++)
 		{
-			if (indicator == 0x91) return true;
-
-			throw WolfRPGException(std::format("{}CommonEvent data indicator not 0x92 or 0x91 (got {:#02x})", ERROR_TAG, indicator));
+			if (!m_commands.Read(coder).Valid())
+				throw WolfRPGException(std::format("{}Initialization of Command #{} in CommonEvent #{} failed", ERROR_TAG, i, m_id));
 		}
 
-		m_unknown10Valid = true;
-		m_unknown10      = coder.ReadString();
-		m_unknown12      = coder.ReadInt();
+		Description::Read(coder, *this);
 
-		indicator = coder.ReadByte();
-		if (indicator != 0x92)
-			throw WolfRPGException(std::format("{}CommonEvent data indicator not 0x92 (got {:#02x})", ERROR_TAG, indicator));
+		const uint8_t* pUnknownStart = coder.CurrentData();
+		skipUnknownBlock(coder);
+		m_unknownBlock = coder.SpanFrom(pUnknownStart);
+
+		Tail::Read(coder, *this);
+
+		if (m_endIndicator != END_INDICATOR && m_endIndicator != EXTENSION_INDICATOR)
+			throw WolfRPGException(std::format("{}CommonEvent data indicator not 0x92 or 0x91 (got {:#02x})", ERROR_TAG, m_endIndicator));
 
 		return true;
 	}
@@ -286,25 +276,45 @@ private:
 private:
 	bool m_valid = false;
 
-	uint32_t m_id                       = 0;
-	uint32_t m_intId                    = 0;
-	uint32_t m_unknown1                 = 0;
-	Bytes m_unknown2                    = {};
-	tString m_name                      = TEXT("");
-	Command::Commands m_commands        = {};
-	tString m_unknown11                 = TEXT("");
-	tString m_description               = TEXT("");
-	std::vector<tString> m_unknown3     = {};
-	std::vector<uint8_t> m_unknown4     = {};
-	std::vector<tStrings> m_unknown5    = {};
-	std::vector<uInts> m_unknown6       = {};
-	Bytes m_unknown7                    = {};
-	std::array<tString, 100> m_unknown8 = {};
-	tString m_unknown9                  = TEXT("");
-	tString m_unknown10                 = TEXT("");
-	uint32_t m_unknown12                = 0;
-
-	bool m_unknown10Valid = false;
+	uint32_t m_id                = 0;
+	uint32_t m_intId             = 0;
+	uint32_t m_unknown1          = 0;
+	Bytes m_unknown2             = {};
+	tString m_name               = TEXT("");
+	Command::Commands m_commands = {};
+	PooledString m_unknown11     = {};
+	tString m_description        = TEXT("");
+	SourceSpan m_unknownBlock    = {}; // Unknown data 3-8
+	PooledString m_unknown9      = {};
+	PooledString m_unknown10     = {};
+	uint32_t m_unknown12         = 0;
+	uint8_t m_endIndicator       = END_INDICATOR; // EXTENSION_INDICATOR if unknown 10 and 12 are present
+
+	static constexpr uint32_t UNKNOWN_STRING_COUNT = 100;
+	static constexpr uint8_t END_INDICATOR         = 0x91;
+	static constexpr uint8_t EXTENSION_INDICATOR   = 0x92;
+
+	// Fields in front of the commands, between the commands and the unknown block and behind the unknown block
+	using Head = schema::Record<
+		schema::Indicator<0x8E, "CommonEvent header">,
+		schema::Int<&CommonEvent::m_intId>,
+		schema::Int<&CommonEvent::m_unknown1>,
+		schema::Raw<&CommonEvent::m_unknown2, 7>,
+		schema::String<&CommonEvent::m_name>>;
+
+	using Description = schema::Record<
+		schema::String<&CommonEvent::m_unknown11>,
+		schema::String<&CommonEvent::m_description>,
+		schema::Indicator<0x8F, "CommonEvent data">>;
+
+	using Tail = schema::Record<
+		schema::Indicator<END_INDICATOR, "CommonEvent data">,
+		schema::String<&CommonEvent::m_unknown9>,
+		schema::Byte<&CommonEvent::m_endIndicator>,
+		schema::WhenEqual<&CommonEvent::m_endIndicator, EXTENSION_INDICATOR,
+						  schema::String<&CommonEvent::m_unknown10>,
+						  schema::Int<&CommonEvent::m_unknown12>,
+						  schema::Indicator<EXTENSION_INDICATOR, "CommonEvent data">>>;
 };
 
 class CommonEvents : public WolfDataBase
@@ -324,22 +334,25 @@ public:
 			m_valid = Load(filePath);
 	}
 
+	CommonEvents(const std::filesystem::path& filePath, Bytes buffer) :
+		WolfDataBase(filePath, MAGIC_NUMBER, WolfFileType::CommonEvent, false, SEED_INDICES),
+		m_valid(false)
+	{
+		m_valid = Load(std::move(buffer));
+	}
+
 	void ToJson(const std::filesystem::path& outputPath) const
 	{
 		for (const CommonEvent& ev : m_events)
 		{
-			nlohmann::ordered_json j = ev.ToJson();
-
 			// Get the file name without the extension
 			const tString comEvName = std::format(TEXT("{}_{}"), ev.GetID(), EscapePath(ev.GetName()));
 
 			std::filesystem::path outputFilePath = outputPath / comEvName;
 			outputFilePath += ".json"; // Don't use replace_extension here in case the filename contains a dot
 
-			std::ofstream out(outputFilePath);
-			out << j.dump(4);
-
-			out.close();
+			JsonWriter writer(outputFilePath);
+			ev.WriteJson(writer);
 		}
 	}
 
@@ -352,22 +365,23 @@ public:
 			std::filesystem::path patchFilePath = patchFolderPath / comEvName;
 			patchFilePath += ".json"; // Don't use replace_extension here in case the filename contains a dot
 
-			if (!std::filesystem::exists(patchFilePath))
+			if (!JsonStream::Exists(patchFilePath))
 				throw WolfRPGException(std::format(L"{}Patch file not found for CommonEvent ID {}: {}", ERROR_TAGW, ev.GetID(), patchFilePath.wstring()));
 
-			std::ifstream in(patchFilePath);
-			nlohmann::ordered_json j;
-			in >> j;
-			in.close();
-
-			ev.Patch(j);
+			if (ev.Patch(JsonStream::Parse(patchFilePath)))
+				markModified();
 		}
+
+		m_nameIndex.Reset();
 	}
 
 	void FixPro35EventDescriptions()
 	{
 		for (CommonEvent& ev : m_events)
-			ev.FixPro35Description();
+		{
+			if (ev.FixPro35Description())
+				markModified();
+		}
 	}
 
 	const CommonEvent::CommonEvents& GetEvents() const
@@ -375,6 +389,57 @@ public:
 		return m_events;
 	}
 
+	// Returns nullptr if there is no common event with the given ID
+	const CommonEvent* FindEvent(const uint32_t& id) const
+	{
+		const std::optional<std::size_t> pos = findEventPos(id);
+		return pos ? &m_events[*pos] : nullptr;
+	}
+
+	// Returns the first common event with the given name or nullptr if there is none
+	const CommonEvent* FindEventByName(const tString& name) const
+	{
+		const std::optional<std::size_t> pos = m_nameIndex.Find(name, [this](const auto& insert) {
+			for (std::size_t i = 0; i < m_events.size(); i++)
+				insert(m_events[i].GetName(), i);
+		});
+
+		return pos ? &m_events[*pos] : nullptr;
+	}
+
+	// Entry of a sparse patch (see SparsePatch.hpp), addresses a common event by its ID
+	bool PatchEntry(const nlohmann::ordered_json& j)
+	{
+		CHECK_JSON_KEY(j, "common", "common event");
+
+		if (!findEvent(j["common"].get<uint32_t>()).PatchEntry(j)) return false;
+
+		m_nameIndex.Reset();
+		markModified();
+		return true;
+	}
+
+	// Adds the texts of the common events to the table (see TextTable.hpp), the events are keyed by their ID
+	void ExportTexts(TextTable& table) const
+	{
+		for (const CommonEvent& ev : m_events)
+			ev.ExportTexts(table, std::format("common/{}", ev.GetID()));
+	}
+
+	// Returns true if a common event was changed by the table
+	bool ApplyTexts(const TextTable& table)
+	{
+		bool modified = false;
+
+		for (CommonEvent& ev : m_events)
+			modified |= ev.ApplyTexts(table, std::format("common/{}", ev.GetID()));
+
+		if (modified)
+			markModified();
+
+		return modified;
+	}
+
 	const bool& IsValid() const
 	{
 		return m_valid;
@@ -394,10 +459,15 @@ protected:
 		}
 
 		uint32_t eventCnt = coder.ReadInt();
-		m_events          = CommonEvent::CommonEvents(eventCnt);
+		m_events.reserve(eventCnt);
 
-		for (uint32_t i = 0; i < eventCnt; i++)
-			m_events[i] = CommonEvent(coder, i);
+		if (eventCnt >= PARALLEL_MIN_EVENTS)
+			loadEventsParallel(coder, eventCnt);
+		else
+		{
+			for (uint32_t i = 0; i < eventCnt; i++)
+				m_events.emplace_back(coder, i);
+		}
 
 		m_terminator = coder.ReadByte();
 		if (m_terminator < 0x89)
@@ -438,13 +508,58 @@ protected:
 		}
 	}
 
-	nlohmann::ordered_json toJson() const
+	void writeJson([[maybe_unused]] JsonWriter& writer) const
 	{
-		return nlohmann::ordered_json();
 	}
 
-	void patch([[maybe_unused]] const nlohmann::ordered_json& j)
+	bool patch([[maybe_unused]] const nlohmann::ordered_json& j)
 	{
+		return false;
+	}
+
+private:
+	// The first pass only determines the byte range of every common event, the events are then parsed in parallel
+	void loadEventsParallel(FileCoder& coder, const uint32_t& eventCnt)
+	{
+		std::vector<SourceSpan> parts;
+		parts.reserve(eventCnt);
+
+		for (uint32_t i = 0; i < eventCnt; i++)
+		{
+			const uint8_t* pStart = coder.CurrentData();
+			CommonEvent::Skip(coder);
+			parts.push_back(coder.SpanFrom(pStart));
+		}
+
+		std::vector<std::optional<CommonEvent>> events(parts.size());
+
+		decodeParallel(parts, [&](FileCoder& partCoder, const std::size_t& index) {
+			events[index].emplace(partCoder, static_cast<uint32_t>(index));
+		});
+
+		for (std::optional<CommonEvent>& ev : events)
+			m_events.push_back(std::move(*ev));
+	}
+
+	std::optional<std::size_t> findEventPos(const uint32_t& id) const
+	{
+		// The common events are usually stored in the order of their IDs
+		if (id < m_events.size() && m_events[id].GetID() == id)
+			return id;
+
+		return m_idIndex.Find(id, [this](const auto& insert) {
+			for (std::size_t i = 0; i < m_events.size(); i++)
+				insert(m_events[i].GetID(), i);
+		});
+	}
+
+	CommonEvent& findEvent(const uint32_t& id)
+	{
+		const std::optional<std::size_t> pos = findEventPos(id);
+		if (!pos)
+			throw WolfRPGException(std::format("{}Common event with ID {} not found", ERROR_TAG, id));
+
+		return m_events[*pos];
 	}
 
 private:
@@ -452,11 +567,18 @@ private:
 
 	CommonEvent::CommonEvents m_events = {};
 
+	// The names of the common events can be patched, the name index is reset whenever that might have happened
+	LazyIndex<uint32_t> m_idIndex  = {};
+	LazyIndex<tString> m_nameIndex = {};
+
 	uint8_t m_version    = 0;
 	uint8_t m_terminator = 0;
 
 	bool m_v35 = false;
 
+	// Files with fewer common events are parsed sequentially, splitting them is not worth it
+	static constexpr uint32_t PARALLEL_MIN_EVENTS = 64;
+
 	inline static const SeedIncides SEED_INDICES = { 0, 3, 9 };
 	inline static const MagicNumber MAGIC_NUMBER = { { 0x57, 0x00, 0x00, 0x4F, 0x4C, 0x00, 0x46, 0x43, 0x00 }, 5 };
 };
@@ -27,9 +27,14 @@
 #pragma once
 
 #include "FileCoder.hpp"
+#include "JsonStream.hpp"
+#include "JsonWriter.hpp"
+#include "LazyIndex.hpp"
+#include "Schema.hpp"
 
 #include <format>
 #include <fstream>
+#include <memory>
 #include <nlohmann/json.hpp>
 #include <string>
 
@@ -40,52 +45,55 @@ public:
 
 	explicit Field(FileCoder& coder)
 	{
-		m_name = coder.ReadString();
+		ProjectLayout::Read(coder, *this);
 	}
 
 	void DumpProject(FileCoder& coder) const
 	{
-		coder.WriteString(m_name);
+		ProjectLayout::Write(coder, *this);
 	}
 
-	nlohmann::ordered_json ToJson() const
+	// The string and int arguments of all fields are stored one after the other in the project file (see Type::ReadProject)
+	void ReadStringArgs(FileCoder& coder)
 	{
-		nlohmann::ordered_json j;
-		j["name"] = ToUTF8(m_name);
+		StringArgsLayout::Read(coder, *this);
+	}
 
-		if (!m_stringArgs.empty())
-		{
-			j["stringArgs"] = nlohmann::ordered_json::array();
+	void DumpStringArgs(FileCoder& coder) const
+	{
+		StringArgsLayout::Write(coder, *this);
+	}
 
-			for (const tString& stringArg : m_stringArgs)
-				j["stringArgs"].push_back(ToUTF8(stringArg));
-		}
+	void ReadArgs(FileCoder& coder)
+	{
+		ArgsLayout::Read(coder, *this);
+	}
+
+	void DumpArgs(FileCoder& coder) const
+	{
+		ArgsLayout::Write(coder, *this);
+	}
 
-		return j;
+	void WriteJson(JsonWriter& writer) const
+	{
+		JsonLayout::WriteJson(writer, *this);
 	}
 
 	void Patch(const nlohmann::ordered_json& j)
 	{
 		CHECK_JSON_KEY(j, "name", "fields");
 
-		m_name = ToUTF16(j["name"].get<std::string>());
-
-		if (j.contains("stringArgs"))
-		{
-			m_stringArgs.clear();
-			for (const auto& stringArg : j["stringArgs"])
-				m_stringArgs.push_back(ToUTF16(stringArg.get<std::string>()));
-		}
+		JsonLayout::Patch(j, *this);
 	}
 
 	void ReadDat(FileCoder& coder)
 	{
-		m_indexInfo = coder.ReadInt();
+		DatLayout::Read(coder, *this);
 	}
 
 	void DumpDat(FileCoder& coder) const
 	{
-		coder.WriteInt(m_indexInfo);
+		DatLayout::Write(coder, *this);
 	}
 
 	bool IsValid() const
@@ -121,7 +129,7 @@ public:
 		return m_type;
 	}
 
-	void SetUnknown1(const tString& unknown1)
+	void SetUnknown1(const PooledString& unknown1)
 	{
 		m_unknown1 = unknown1;
 	}
@@ -166,6 +174,11 @@ public:
 		return m_name;
 	}
 
+	const std::string& GetNameUTF8() const
+	{
+		return m_name.UTF8();
+	}
+
 	void SetName(const tString& name)
 	{
 		m_name = name;
@@ -173,9 +186,9 @@ public:
 
 private:
 private:
-	tString m_name          = TEXT("");
+	PooledString m_name     = {};
 	uint8_t m_type          = 0;
-	tString m_unknown1      = TEXT("");
+	PooledString m_unknown1 = {};
 	tStrings m_stringArgs   = {};
 	uInts m_args            = {};
 	uint32_t m_defaultValue = 0;
@@ -183,72 +196,169 @@ private:
 
 	static const uint32_t STRING_START = 0x07D0;
 	static const uint32_t INT_START    = 0x03E8;
+
+	using ProjectLayout    = schema::Record<schema::String<&Field::m_name>>;
+	using StringArgsLayout = schema::Record<schema::StringArray<&Field::m_stringArgs>>;
+	using ArgsLayout       = schema::Record<schema::IntArray<&Field::m_args>>;
+	using DatLayout        = schema::Record<schema::Int<&Field::m_indexInfo>>;
+
+	using JsonLayout = schema::JsonRecord<
+		schema::Text<"name", &Field::m_name>,
+		schema::OptionalTextList<"stringArgs", &Field::m_stringArgs>>;
 };
 
 using Fields = std::vector<Field>;
 
-class Data
+// Rows of a type in columnar form, the int values of all rows form one row-major matrix and every string field has its own column.
+// The fields of the type are passed in, they decide which column holds the value of a field (see Field::Index).
+class Table
 {
 public:
-	// Don't use = default here to prevent potential issues with a vector of Data
-	Data() {}
+	// Read-only view of a single row
+	class Row
+	{
+	public:
+		Row(const Table& table, const std::size_t& row) :
+			m_table(table),
+			m_row(row)
+		{
+		}
+
+		const tString& GetName() const
+		{
+			return m_table.m_names[m_row];
+		}
+
+		uint32_t GetInt(const uint32_t& index) const
+		{
+			return m_table.m_intValues[m_row * m_table.m_intCount + index];
+		}
+
+		const tString& GetString(const uint32_t& index) const
+		{
+			return m_table.m_stringColumns[index][m_row];
+		}
 
-	explicit Data(FileCoder& coder)
+	private:
+		const Table& m_table;
+		std::size_t m_row;
+	};
+
+	Table() = default;
+
+	void ReadProject(FileCoder& coder, const uint32_t& rowCount)
 	{
-		m_name = coder.ReadString();
+		m_rowIndex.Reset();
+
+		m_names.reserve(rowCount);
+		for (uint32_t i = 0; i < rowCount; i++)
+			m_names.push_back(coder.ReadString());
 	}
 
 	void DumpProject(FileCoder& coder) const
 	{
-		coder.WriteString(m_name);
+		for (const tString& name : m_names)
+			coder.WriteString(name);
 	}
 
-	nlohmann::ordered_json ToJson() const
+	void ReadDat(FileCoder& coder, const Fields& fields, const uint32_t& fieldsSize, const uint32_t& rowCount)
 	{
-		nlohmann::ordered_json j;
-		j["name"] = ToUTF8(m_name);
-		j["data"] = nlohmann::json::array();
+		if (m_names.size() > rowCount)
+		{
+			m_names.resize(rowCount);
+			m_rowIndex.Reset();
+		}
+
+		m_intCount    = 0;
+		m_stringCount = 0;
+
+		for (uint32_t i = 0; i < fieldsSize; i++)
+		{
+			if (fields[i].IsString())
+				m_stringCount++;
+			else
+				m_intCount++;
+		}
 
-		if (m_stringValues.empty() && m_intValues.empty())
-			return j;
+		m_intValues.resize(m_names.size() * m_intCount);
+		m_stringColumns.assign(m_stringCount, tStrings(m_names.size()));
 
-		for (const Field& field : *m_pFields)
+		for (std::size_t row = 0; row < m_names.size(); row++)
 		{
-			nlohmann::ordered_json fieldData;
-			fieldData["name"] = ToUTF8(field.GetName());
+			uint32_t* pInts = m_intValues.data() + row * m_intCount;
+			for (uint32_t i = 0; i < m_intCount; i++)
+				pInts[i] = coder.ReadInt();
 
-			if (field.IsValid())
+			for (tStrings& column : m_stringColumns)
+				column[row] = coder.ReadString();
+		}
+	}
+
+	void DumpDat(FileCoder& coder) const
+	{
+		for (std::size_t row = 0; row < m_names.size(); row++)
+		{
+			const uint32_t* pInts = m_intValues.data() + row * m_intCount;
+			for (uint32_t i = 0; i < m_intCount; i++)
+				coder.WriteInt(pInts[i]);
+
+			for (const tStrings& column : m_stringColumns)
+				coder.WriteString(column[row]);
+		}
+	}
+
+	void WriteRowJson(JsonWriter& writer, const std::size_t& row, const Fields& fields) const
+	{
+		writer.BeginObject();
+		writer.Value("name", ToUTF8(m_names[row]));
+
+		writer.Key("data");
+		writer.BeginArray();
+
+		if (HasValues())
+		{
+			const Row values = GetRow(row);
+
+			for (const Field& field : fields)
 			{
-				if (field.IsString())
-					fieldData["value"] = ToUTF8(m_stringValues[field.Index()]);
+				writer.BeginObject();
+				writer.Value("name", field.GetNameUTF8());
+
+				if (field.IsValid())
+				{
+					if (field.IsString())
+						writer.Value("value", ToUTF8(values.GetString(field.Index())));
+					else
+						writer.Value("value", values.GetInt(field.Index()));
+				}
 				else
-					fieldData["value"] = m_intValues[field.Index()];
-			}
-			else
-				fieldData["value"] = "INVALID_IGNORE";
+					writer.Value("value", "INVALID_IGNORE");
 
-			j["data"].push_back(fieldData);
+				writer.EndObject();
+			}
 		}
 
-		return j;
+		writer.EndArray();
+		writer.EndObject();
 	}
 
-	void Patch(const nlohmann::ordered_json& j)
+	void PatchRow(const nlohmann::ordered_json& j, const std::size_t& row, const Fields& fields)
 	{
 		CHECK_JSON_KEY(j, "name", "data");
 		CHECK_JSON_KEY(j, "data", "data");
 
-		m_name = ToUTF16(j["name"]);
+		m_names[row] = ToUTF16(j["name"]);
+		m_rowIndex.Reset();
 
-		if (m_stringValues.empty() && m_intValues.empty()) return;
+		if (!HasValues()) return;
 
-		for (std::size_t i = 0; i < m_pFields->size(); i++)
+		for (std::size_t i = 0; i < fields.size(); i++)
 		{
 			const nlohmann::ordered_json& fieldData = j["data"][i];
 			const std::string dataStr               = std::format("data[{}]", i);
 
-			const Field& field    = m_pFields->at(i);
-			std::string fieldName = ToUTF8(field.GetName());
+			const Field& field           = fields[i];
+			const std::string& fieldName = field.GetNameUTF8();
 
 			if (!field.IsValid()) continue;
 
@@ -261,80 +371,186 @@ public:
 				throw WolfRPGException(std::format("{}Data field name mismatch at index {} - Expected: \"{}\" - Got: \"{}\"", ERROR_TAG, i, fieldName, fieldNameJson));
 
 			if (field.IsString())
-				m_stringValues[field.Index()] = ToUTF16(fieldData["value"].get<std::string>());
+				stringValue(row, field.Index()) = ToUTF16(fieldData["value"].get<std::string>());
 			else
-				m_intValues[field.Index()] = fieldData["value"].get<uint32_t>();
+				intValue(row, field.Index()) = fieldData["value"].get<uint32_t>();
 		}
 	}
 
-	void ReadDat(FileCoder& coder, Fields& fields, const uint32_t& fieldsSize)
+	// Compact layout, the row is an array of its name followed by the values of the given fields
+	void WriteRowCompact(JsonWriter& writer, const std::size_t& row, const uInts& columns, const Fields& fields) const
 	{
-		m_pFields       = &fields;
-		uint32_t intCnt = 0;
-		uint32_t strCnt = 0;
+		writer.BeginArray();
+		writer.Value(ToUTF8(m_names[row]));
 
-		for (uint32_t i = 0; i < fieldsSize; i++)
+		const Row values = GetRow(row);
+
+		for (const uint32_t& column : columns)
 		{
-			if (fields[i].IsString())
-				strCnt++;
+			const Field& field = fields[column];
+
+			if (field.IsString())
+				writer.Value(ToUTF8(values.GetString(field.Index())));
 			else
-				intCnt++;
+				writer.Value(values.GetInt(field.Index()));
 		}
 
-		for (uint32_t i = 0; i < intCnt; i++)
-			m_intValues.push_back(coder.ReadInt());
+		writer.EndArray();
+	}
+
+	// The values are assigned by their position, the columns have to be checked by the caller
+	void PatchRowCompact(const nlohmann::ordered_json& j, const std::size_t& row, const uInts& columns, const Fields& fields)
+	{
+		if (!j.is_array() || j.size() != columns.size() + 1)
+			throw WolfRPGException(std::format("{}Row {} has to be an array of its name and {} values", ERROR_TAG, row, columns.size()));
+
+		m_names[row] = ToUTF16(j[0].get<std::string>());
+		m_rowIndex.Reset();
+
+		for (std::size_t i = 0; i < columns.size(); i++)
+		{
+			const Field& field = fields[columns[i]];
 
-		for (uint32_t i = 0; i < strCnt; i++)
-			m_stringValues.push_back(coder.ReadString());
+			if (field.IsString())
+				stringValue(row, field.Index()) = ToUTF16(j[i + 1].get<std::string>());
+			else
+				intValue(row, field.Index()) = j[i + 1].get<uint32_t>();
+		}
 	}
 
-	void DumpDat(FileCoder& coder) const
+	// Entry of a sparse patch, addresses either a value (by its field index) or the name of the row
+	bool PatchEntry(const nlohmann::ordered_json& j, const std::size_t& row, const Fields& fields)
 	{
-		for (const uint32_t& i : m_intValues)
-			coder.WriteInt(i);
+		if (!j.contains("field"))
+		{
+			CHECK_JSON_KEY(j, "name", "data");
+			m_rowIndex.Reset();
+			return UpdateValue(m_names[row], ToUTF16(j["name"].get<std::string>()));
+		}
+
+		CHECK_JSON_KEY(j, "value", "data");
+
+		const uint32_t fieldIdx = j["field"].get<uint32_t>();
+		if (fieldIdx >= fields.size())
+			throw WolfRPGException(std::format("{}Field index out of range in patch (field: {}, field count: {})", ERROR_TAG, fieldIdx, fields.size()));
+
+		const Field& field = fields[fieldIdx];
+		if (!field.IsValid() || !HasValues())
+			throw WolfRPGException(std::format("{}Field {} of row \"{}\" has no value", ERROR_TAG, fieldIdx, ToUTF8(m_names[row])));
 
-		for (const tString& str : m_stringValues)
-			coder.WriteString(str);
+		if (field.IsString())
+			return UpdateValue(stringValue(row, field.Index()), ToUTF16(j["value"].get<std::string>()));
+
+		return UpdateValue(intValue(row, field.Index()), j["value"].get<uint32_t>());
 	}
 
-	const tString& GetName() const
+	// The values of the string fields are keyed by prefix/row index/field index
+	void ExportTexts(TextTable& table, const std::string& prefix, const Fields& fields) const
 	{
-		return m_name;
+		if (m_stringCount == 0) return;
+
+		for (std::size_t row = 0; row < m_names.size(); row++)
+		{
+			for (std::size_t i = 0; i < fields.size(); i++)
+			{
+				const Field& field = fields[i];
+
+				if (field.IsValid() && field.IsString())
+					table.Add(std::format("{}/{}/{}", prefix, row, i), m_stringColumns[field.Index()][row]);
+			}
+		}
 	}
 
-	void SetName(const tString& name)
+	bool ApplyTexts(const TextTable& table, const std::string& prefix, const Fields& fields)
 	{
-		m_name = name;
+		if (m_stringCount == 0) return false;
+
+		bool modified = false;
+
+		for (std::size_t row = 0; row < m_names.size(); row++)
+		{
+			for (std::size_t i = 0; i < fields.size(); i++)
+			{
+				const Field& field = fields[i];
+				if (!field.IsValid() || !field.IsString()) continue;
+
+				const std::string* pText = table.Find(std::format("{}/{}/{}", prefix, row, i));
+				if (pText)
+					modified |= UpdateValue(stringValue(row, field.Index()), ToUTF16(*pText));
+			}
+		}
+
+		return modified;
+	}
+
+	Row GetRow(const std::size_t& row) const
+	{
+		return Row(*this, row);
+	}
+
+	std::size_t Size() const
+	{
+		return m_names.size();
+	}
+
+	// Position of the first row with the given name
+	std::optional<std::size_t> FindRow(const tString& name) const
+	{
+		return m_rowIndex.Find(name, [this](const auto& insert) {
+			for (std::size_t i = 0; i < m_names.size(); i++)
+				insert(m_names[i], i);
+		});
+	}
+
+	bool HasValues() const
+	{
+		return (m_intCount + m_stringCount) > 0;
 	}
 
 private:
+	uint32_t& intValue(const std::size_t& row, const uint32_t& index)
+	{
+		return m_intValues[row * m_intCount + index];
+	}
+
+	tString& stringValue(const std::size_t& row, const uint32_t& index)
+	{
+		return m_stringColumns[index][row];
+	}
+
 private:
-	tString m_name          = TEXT("");
-	uInts m_intValues       = {};
-	tStrings m_stringValues = {};
-	Fields* m_pFields       = nullptr;
+	tStrings m_names                      = {};
+	uInts m_intValues                     = {};
+	std::vector<tStrings> m_stringColumns = {};
+	uint32_t m_intCount                   = 0;
+	uint32_t m_stringCount                = 0;
+	LazyIndex<tString> m_rowIndex         = {};
 };
 
-using Datas = std::vector<Data>;
-
 class Type
 {
 public:
+	// Layout of the rows in the JSON dump
+	enum class JsonLayout
+	{
+		Fields,    // Every row lists all fields with their name and value
+		Compact,   // Every row is an array of its name and the values of the string fields
+		CompactAll // Every row is an array of its name and the values of all valid fields
+	};
+
 	explicit Type(FileCoder& coder)
 	{
-		m_name            = coder.ReadString();
+		Head::Read(coder, *this);
+
 		uint32_t fieldCnt = coder.ReadInt();
 		for (uint32_t i = 0; i < fieldCnt; i++)
 			m_fields.push_back(Field(coder));
 
-		uint32_t dataCnt = coder.ReadInt();
-		for (uint32_t i = 0; i < dataCnt; i++)
-			m_data.push_back(Data(coder));
+		m_table.ReadProject(coder, coder.ReadInt());
 
-		m_description = coder.ReadString();
+		Description::Read(coder, *this);
 
-		m_fieldTypeListSize = coder.ReadInt();
-		uint32_t index      = 0;
+		uint32_t index = 0;
 
 		for (index = 0; index < m_fields.size(); index++)
 			m_fields[index].SetType(coder.ReadByte());
@@ -343,27 +559,15 @@ public:
 
 		index = coder.ReadInt();
 		for (uint32_t i = 0; i < index; i++)
-			m_fields[i].SetUnknown1(coder.ReadString());
+			m_fields[i].SetUnknown1(coder.ReadPooledString());
 
 		index = coder.ReadInt();
 		for (uint32_t i = 0; i < index; i++)
-		{
-			tStrings stringArgs;
-			uint32_t argsCnt = coder.ReadInt();
-			for (uint32_t j = 0; j < argsCnt; j++)
-				stringArgs.push_back(coder.ReadString());
-			m_fields[i].SetStringArgs(stringArgs);
-		}
+			m_fields[i].ReadStringArgs(coder);
 
 		index = coder.ReadInt();
 		for (uint32_t i = 0; i < index; i++)
-		{
-			uInts args;
-			uint32_t argsCnt = coder.ReadInt();
-			for (uint32_t j = 0; j < argsCnt; j++)
-				args.push_back(coder.ReadInt());
-			m_fields[i].SetArgs(args);
-		}
+			m_fields[i].ReadArgs(coder);
 
 		index = coder.ReadInt();
 		for (uint32_t i = 0; i < index; i++)
@@ -372,19 +576,16 @@ public:
 
 	void DumpProject(FileCoder& coder) const
 	{
-		coder.WriteString(m_name);
+		Head::Write(coder, *this);
 		coder.WriteInt(m_fields.size());
 
 		for (const Field& field : m_fields)
 			field.DumpProject(coder);
 
-		coder.WriteInt(m_data.size());
-		for (const Data& data : m_data)
-			data.DumpProject(coder);
-
-		coder.WriteString(m_description);
+		coder.WriteInt(m_table.Size());
+		m_table.DumpProject(coder);
 
-		coder.WriteInt(m_fieldTypeListSize);
+		Description::Write(coder, *this);
 
 		for (const Field& field : m_fields)
 			coder.WriteByte(field.GetType());
@@ -398,19 +599,11 @@ public:
 
 		coder.WriteInt(m_fields.size());
 		for (const Field& field : m_fields)
-		{
-			coder.WriteInt(field.GetStringArgs().size());
-			for (const tString& stringArg : field.GetStringArgs())
-				coder.WriteString(stringArg);
-		}
+			field.DumpStringArgs(coder);
 
 		coder.WriteInt(m_fields.size());
 		for (const Field& field : m_fields)
-		{
-			coder.WriteInt(field.GetArgs().size());
-			for (const uint32_t& arg : field.GetArgs())
-				coder.WriteInt(arg);
-		}
+			field.DumpArgs(coder);
 
 		coder.WriteInt(m_fields.size());
 		for (const Field& field : m_fields)
@@ -419,60 +612,66 @@ public:
 
 	bool ReadDat(FileCoder& coder)
 	{
-		VERIFY_MAGIC(coder, DAT_TYPE_SEPARATOR);
-		m_unknown1   = coder.ReadInt();
-		m_fieldsSize = coder.ReadInt();
-
-		if (m_unknown1 == STRING_INDICATOR)
-			m_unknown2 = coder.ReadString();
+		DatHead::Read(coder, *this);
 
 		for (uint32_t i = 0; i < m_fieldsSize; i++)
 			m_fields[i].ReadDat(coder);
 
-		uint32_t dataSize = coder.ReadInt();
-
-		if (m_data.size() > dataSize)
-			m_data.resize(dataSize);
-
-		for (Data& datum : m_data)
-			datum.ReadDat(coder, m_fields, m_fieldsSize);
+		m_table.ReadDat(coder, m_fields, m_fieldsSize, coder.ReadInt());
 
 		return true;
 	}
 
 	void DumpDat(FileCoder& coder) const
 	{
-		coder.Write(DAT_TYPE_SEPARATOR);
-		coder.WriteInt(m_unknown1);
-
-		coder.WriteInt(m_fieldsSize);
-
-		if (m_unknown1 == STRING_INDICATOR)
-			coder.WriteString(m_unknown2);
+		DatHead::Write(coder, *this);
 
 		for (uint32_t i = 0; i < m_fieldsSize; i++)
 			m_fields[i].DumpDat(coder);
 
-		coder.WriteInt(m_data.size());
-		for (const Data& datum : m_data)
-			datum.DumpDat(coder);
+		coder.WriteInt(m_table.Size());
+		m_table.DumpDat(coder);
 	}
 
-	nlohmann::ordered_json ToJson() const
+	void WriteJson(JsonWriter& writer) const
 	{
-		nlohmann::ordered_json j;
-		j["name"]        = ToUTF8(m_name);
-		j["description"] = ToUTF8(m_description);
-		j["fields"]      = nlohmann::json::array();
-		j["data"]        = nlohmann::json::array();
+		writer.BeginObject();
+		writer.Value("name", ToUTF8(m_name));
+		writer.Value("description", ToUTF8(m_description));
 
+		writer.Key("fields");
+		writer.BeginArray();
 		for (const Field& field : m_fields)
-			j["fields"].push_back(field.ToJson());
+			field.WriteJson(writer);
+		writer.EndArray();
 
-		for (const Data& data : m_data)
-			j["data"].push_back(data.ToJson());
+		if (s_jsonLayout == JsonLayout::Fields)
+		{
+			writer.Key("data");
+			writer.BeginArray();
+			for (std::size_t i = 0; i < m_table.Size(); i++)
+				m_table.WriteRowJson(writer, i, m_fields);
+			writer.EndArray();
+		}
+		else
+		{
+			// The field list is stated once, every row only contains the values of these fields
+			const uInts columns = compactColumns();
+
+			writer.Key("columns");
+			writer.BeginArray();
+			for (const uint32_t& column : columns)
+				writer.Value(column);
+			writer.EndArray();
+
+			writer.Key("data");
+			writer.BeginArray();
+			for (std::size_t i = 0; i < m_table.Size(); i++)
+				m_table.WriteRowCompact(writer, i, columns, m_fields);
+			writer.EndArray();
+		}
 
-		return j;
+		writer.EndObject();
 	}
 
 	void Patch(const nlohmann::ordered_json& j)
@@ -491,19 +690,86 @@ public:
 		for (std::size_t i = 0; i < m_fields.size(); i++)
 			m_fields[i].Patch(j["fields"][i]);
 
-		if (m_data.size() != j["data"].size())
-			throw WolfRPGException(std::format("{}Count mismatch for object 'data' expected: {} - got: {}", ERROR_TAG, m_data.size(), j["data"].size()));
+		if (m_table.Size() != j["data"].size())
+			throw WolfRPGException(std::format("{}Count mismatch for object 'data' expected: {} - got: {}", ERROR_TAG, m_table.Size(), j["data"].size()));
+
+		// Dumps in the compact layout are recognized by their column list, independent of the current layout
+		if (j.contains("columns"))
+		{
+			const uInts columns = j["columns"].get<uInts>();
+			if (columns != compactColumns(JsonLayout::Compact) && columns != compactColumns(JsonLayout::CompactAll))
+				throw WolfRPGException(std::format(L"{}Column mismatch for type \"{}\", the columns have to match the values of the dump", ERROR_TAGW, m_name));
+
+			for (std::size_t i = 0; i < m_table.Size(); i++)
+				m_table.PatchRowCompact(j["data"][i], i, columns, m_fields);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < m_table.Size(); i++)
+				m_table.PatchRow(j["data"][i], i, m_fields);
+		}
+	}
+
+	// Entry of a sparse patch, addresses a data row, the name of a field or the name and description of the type
+	bool PatchEntry(const nlohmann::ordered_json& j)
+	{
+		if (j.contains("row"))
+		{
+			const uint32_t row = j["row"].get<uint32_t>();
+			if (row >= m_table.Size())
+				throw WolfRPGException(std::format("{}Data row out of range in patch (row: {}, row count: {})", ERROR_TAG, row, m_table.Size()));
+
+			return m_table.PatchEntry(j, row, m_fields);
+		}
+
+		if (j.contains("field"))
+		{
+			CHECK_JSON_KEY(j, "name", "field");
+
+			const uint32_t fieldIdx = j["field"].get<uint32_t>();
+			if (fieldIdx >= m_fields.size())
+				throw WolfRPGException(std::format("{}Field index out of range in patch (field: {}, field count: {})", ERROR_TAG, fieldIdx, m_fields.size()));
+
+			const tString name = ToUTF16(j["name"].get<std::string>());
+			if (m_fields[fieldIdx].GetName() == name) return false;
+
+			m_fields[fieldIdx].SetName(name);
+			return true;
+		}
+
+		bool modified = false;
+
+		if (j.contains("name"))
+			modified |= UpdateValue(m_name, ToUTF16(j["name"].get<std::string>()));
 
-		for (std::size_t i = 0; i < m_data.size(); i++)
-			m_data[i].Patch(j["data"][i]);
+		if (j.contains("description"))
+			modified |= UpdateValue(m_description, ToUTF16(j["description"].get<std::string>()));
+
+		return modified;
+	}
+
+	// The rows are keyed by prefix/row index
+	void ExportTexts(TextTable& table, const std::string& prefix) const
+	{
+		m_table.ExportTexts(table, prefix, m_fields);
 	}
 
-	void FixPro35Description()
+	bool ApplyTexts(const TextTable& table, const std::string& prefix)
 	{
+		return m_table.ApplyTexts(table, prefix, m_fields);
+	}
+
+	// Returns true if the description contained characters which had to be removed
+	bool FixPro35Description()
+	{
+		const std::size_t oldSize = m_description.size();
+
 		// Remove all Ascii characters < 0x20 from the description
 		m_description.erase(std::remove_if(m_description.begin(), m_description.end(),
 										   [](const wchar_t& c) { return c < 0x20 && c != 0x0A && c != 0x0D; }),
 							m_description.end());
+
+		return (m_description.size() != oldSize);
 	}
 
 	const Fields& GetFields() const
@@ -511,9 +777,9 @@ public:
 		return m_fields;
 	}
 
-	const Datas& GetData() const
+	const Table& GetTable() const
 	{
-		return m_data;
+		return m_table;
 	}
 
 	const tString& GetName() const
@@ -536,19 +802,54 @@ public:
 		m_description = description;
 	}
 
+	static void SetJsonLayout(const JsonLayout& layout)
+	{
+		s_jsonLayout = layout;
+	}
+
 private:
+	// Indices of the fields whose values are part of the rows in the compact layout
+	uInts compactColumns(const JsonLayout& layout = s_jsonLayout) const
+	{
+		uInts columns;
+		if (!m_table.HasValues()) return columns;
+
+		for (uint32_t i = 0; i < m_fields.size(); i++)
+		{
+			if (m_fields[i].IsValid() && (layout == JsonLayout::CompactAll || m_fields[i].IsString()))
+				columns.push_back(i);
+		}
+
+		return columns;
+	}
+
 private:
 	tString m_name               = TEXT("");
 	tString m_description        = TEXT("");
 	Fields m_fields              = {};
 	uint32_t m_fieldsSize        = 0;
-	Datas m_data                 = {};
+	Table m_table                = {};
 	uint32_t m_unknown1          = 0;
 	uint32_t m_fieldTypeListSize = 0;
 	tString m_unknown2           = TEXT("");
 
 	inline static const Bytes DAT_TYPE_SEPARATOR{ 0xFE, 0xFF, 0xFF, 0xFF };
 	static constexpr uint32_t STRING_INDICATOR = 0x0001D4C0;
+
+	inline static JsonLayout s_jsonLayout = JsonLayout::Fields;
+
+	// Fields of the project file in front of the field list and behind the table
+	using Head        = schema::Record<schema::String<&Type::m_name>>;
+	using Description = schema::Record<
+		schema::String<&Type::m_description>,
+		schema::Int<&Type::m_fieldTypeListSize>>;
+
+	// Fields of the dat file in front of the field list
+	using DatHead = schema::Record<
+		schema::Magic<DAT_TYPE_SEPARATOR>,
+		schema::Int<&Type::m_unknown1>,
+		schema::Int<&Type::m_fieldsSize>,
+		schema::WhenEqual<&Type::m_unknown1, STRING_INDICATOR, schema::String<&Type::m_unknown2>>>;
 };
 
 using Types = std::vector<Type>;
@@ -564,8 +865,17 @@ public:
 		m_valid = init();
 	}
 
+	// Load from data which is already in memory, e.g., extracted from an archive
+	Database(const std::filesystem::path& projectFilePath, Bytes projectData, const std::filesystem::path& datFilePath, Bytes datData) :
+		m_projectFilePath(projectFilePath),
+		m_datFilePath(datFilePath)
+	{
+		m_valid = init(std::move(projectData), std::move(datData));
+	}
+
 	void Dump(const std::filesystem::path& outputPath) const
 	{
+		if (!copyUnmodified(m_projectFilePath, m_projectFromFile, outputPath))
 		{
 			const std::filesystem::path fileName = ::GetFileName(m_projectFilePath);
 
@@ -578,6 +888,8 @@ public:
 				type.DumpProject(coder);
 		}
 
+		if (copyUnmodified(m_datFilePath, m_datFromFile, outputPath)) return;
+
 		const std::filesystem::path fileName = ::GetFileName(m_datFilePath);
 
 		g_activeFile = fileName;
@@ -612,19 +924,19 @@ public:
 
 		g_activeFile = fileName;
 
-		nlohmann::ordered_json j;
-		j["types"] = nlohmann::json::array();
-
-		for (const Type& type : m_types)
-			j["types"].push_back(type.ToJson());
-
 		std::filesystem::path outputFilePath = outputPath / fileName;
 		outputFilePath += ".json";
 
-		std::ofstream out(outputFilePath);
-		out << j.dump(4);
+		JsonWriter writer(outputFilePath);
+		writer.BeginObject();
 
-		out.close();
+		writer.Key("types");
+		writer.BeginArray();
+		for (const Type& type : m_types)
+			type.WriteJson(writer);
+		writer.EndArray();
+
+		writer.EndObject();
 	}
 
 	void Patch(const std::filesystem::path& patchFolderPath)
@@ -636,27 +948,79 @@ public:
 		std::filesystem::path patchFilePath = patchFolderPath / fileName;
 		patchFilePath += ".json";
 
-		if (!std::filesystem::exists(patchFilePath))
+		if (!JsonStream::Exists(patchFilePath))
 			throw WolfRPGException(std::format(L"{}Patch file not found: {}", ERROR_TAGW, patchFilePath.wstring()));
 
-		nlohmann::ordered_json j;
-		std::ifstream in(patchFilePath);
-		in >> j;
-		in.close();
+		std::size_t typeCount = 0;
 
-		CHECK_JSON_KEY(j, "types", "Database");
+		// The types are patched one by one while the patch is parsed
+		const nlohmann::ordered_json j = JsonStream::Parse(patchFilePath, "types", [&](const std::size_t& index, const nlohmann::ordered_json& typeJ) {
+			typeCount++;
 
-		if (m_types.size() != j["types"].size())
-			throw WolfRPGException(std::format("{}Count mismatch for object 'types' expected: {} - got: {}", ERROR_TAG, m_types.size(), j["types"].size()));
+			if (index >= m_types.size())
+				throw WolfRPGException(std::format("{}Count mismatch for object 'types' expected: {} - got more", ERROR_TAG, m_types.size()));
 
-		for (std::size_t i = 0; i < m_types.size(); i++)
-			m_types[i].Patch(j["types"][i]);
+			// Types which already match the patch are skipped, i.e., an unchanged database is not encoded again
+			if (typeJ.dump(4) == JsonWriter::ToString(m_types[index])) return;
+
+			m_types[index].Patch(typeJ);
+			m_typeIndex.Reset();
+			m_modified = true;
+		});
+
+		CHECK_JSON_KEY(j, "types", "Database");
+
+		if (m_types.size() != typeCount)
+			throw WolfRPGException(std::format("{}Count mismatch for object 'types' expected: {} - got: {}", ERROR_TAG, m_types.size(), typeCount));
 	}
 
 	void FixPro35TypeDescriptions()
 	{
 		for (Type& type : m_types)
-			type.FixPro35Description();
+		{
+			if (type.FixPro35Description())
+				m_modified = true;
+		}
+	}
+
+	// Entry of a sparse patch (see SparsePatch.hpp), addresses a type by its index
+	bool PatchEntry(const nlohmann::ordered_json& j)
+	{
+		CHECK_JSON_KEY(j, "type", "database");
+
+		const uint32_t type = j["type"].get<uint32_t>();
+		if (type >= m_types.size())
+			throw WolfRPGException(std::format("{}Type index out of range in patch (type: {}, type count: {})", ERROR_TAG, type, m_types.size()));
+
+		if (!m_types[type].PatchEntry(j)) return false;
+
+		m_typeIndex.Reset();
+		m_modified = true;
+		return true;
+	}
+
+	// Adds the string values of the database to the table (see TextTable.hpp), the types are keyed by their index
+	void ExportTexts(TextTable& table) const
+	{
+		const std::string prefix = textPrefix();
+
+		for (std::size_t i = 0; i < m_types.size(); i++)
+			m_types[i].ExportTexts(table, std::format("{}/{}", prefix, i));
+	}
+
+	// Returns true if the database was changed by the table
+	bool ApplyTexts(const TextTable& table)
+	{
+		const std::string prefix = textPrefix();
+		bool modified            = false;
+
+		for (std::size_t i = 0; i < m_types.size(); i++)
+			modified |= m_types[i].ApplyTexts(table, std::format("{}/{}", prefix, i));
+
+		if (modified)
+			m_modified = true;
+
+		return modified;
 	}
 
 	const Types& GetTypes() const
@@ -664,26 +1028,57 @@ public:
 		return m_types;
 	}
 
+	// Position of the first type with the given name
+	std::optional<std::size_t> FindType(const tString& name) const
+	{
+		return m_typeIndex.Find(name, [this](const auto& insert) {
+			for (std::size_t i = 0; i < m_types.size(); i++)
+				insert(m_types[i].GetName(), i);
+		});
+	}
+
+	const std::filesystem::path& FileName() const
+	{
+		return m_datFilePath;
+	}
+
 	const bool& IsValid() const
 	{
 		return m_valid;
 	}
 
+	// True if the database was changed since it was loaded
+	bool IsModified() const
+	{
+		return m_modified;
+	}
+
 private:
-	bool init()
+	std::string textPrefix() const
+	{
+		return "db/" + ToUTF8(::GetFileNameNoExt(m_datFilePath).wstring());
+	}
+
+	bool init(Bytes projectData = {}, Bytes datData = {})
 	{
 		g_activeFile = ::GetFileName(m_datFilePath);
-		FileCoder coder(m_datFilePath, FileCoder::Mode::READ, WolfFileType::DataBase, DAT_SEED_INDICES);
+
+		std::unique_ptr<FileCoder> pDatCoder = openCoder(m_datFilePath, std::move(datData), WolfFileType::DataBase, DAT_SEED_INDICES);
+		FileCoder& coder                     = *pDatCoder;
 
 		if (!coder.WasEncrypted())
 			VERIFY_MAGIC(coder, DAT_MAGIC_NUMBER)
 
-		m_version = coder.ReadByte();
+		m_datFromFile = coder.IsFromFile();
+		m_version     = coder.ReadByte();
 
 		// Process the project file
 		{
 			g_activeFile = ::GetFileName(m_projectFilePath);
-			FileCoder coder(m_projectFilePath, FileCoder::Mode::READ, WolfFileType::Project);
+			std::unique_ptr<FileCoder> pProjectCoder = openCoder(m_projectFilePath, std::move(projectData), WolfFileType::Project);
+			FileCoder& coder                         = *pProjectCoder;
+			m_projectFromFile                        = coder.IsFromFile();
+
 			uint32_t typeCnt = coder.ReadInt();
 			for (uint32_t i = 0; i < typeCnt; i++)
 				m_types.push_back(Type(coder));
@@ -714,12 +1109,34 @@ private:
 		return true;
 	}
 
-private:
-	Types m_types       = {};
-	Bytes m_cryptHeader = {};
+	// The file is only read from disk if its data was not passed in
+	static std::unique_ptr<FileCoder> openCoder(const std::filesystem::path& filePath, Bytes data, const WolfFileType& fileType, const SeedIncides& seedIndices = {})
+	{
+		if (data.empty())
+			return std::make_unique<FileCoder>(filePath, FileCoder::Mode::READ, fileType, seedIndices);
 
-	uint8_t m_version = 0;
-	bool m_valid      = false;
+		return std::make_unique<FileCoder>(std::move(data), FileCoder::Mode::READ, fileType, seedIndices);
+	}
+
+	// Unmodified files are copied from the source, when patching in place they are not touched at all
+	bool copyUnmodified(const std::filesystem::path& sourcePath, const bool& fromFile, const std::filesystem::path& outputPath) const
+	{
+		if (m_modified || !fromFile) return false;
+
+		FileCoder::CopyToOutput(sourcePath, outputPath / ::GetFileName(sourcePath));
+		return true;
+	}
+
+private:
+	Types m_types                  = {};
+	Bytes m_cryptHeader            = {};
+	LazyIndex<tString> m_typeIndex = {};
+
+	uint8_t m_version      = 0;
+	bool m_valid           = false;
+	bool m_modified        = false;
+	bool m_projectFromFile = false;
+	bool m_datFromFile     = false;
 	std::filesystem::path m_projectFilePath;
 	std::filesystem::path m_datFilePath;
 
@@ -0,0 +1,154 @@
+/*
+ *  File: DecodeCache.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "FileAccess.hpp"
+#include "Types.hpp"
+#include "WolfRPGUtils.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <optional>
+
+// On disk cache for the decoded (decrypted and decompressed) data of game files.
+// Entries are keyed by a hash of the source file and of everything else which influences the decoding.
+// On a cache hit the entry is mapped directly, i.e., the expensive decryption and LZ4 decompression are skipped.
+// The decoded data is followed by a fixed size trailer storing the decoder state after loading.
+class DecodeCache
+{
+public:
+	struct Trailer
+	{
+		uint32_t magic       = MAGIC;
+		uint32_t version     = VERSION;
+		uint64_t key         = 0;
+		uint32_t offset      = 0;
+		uint32_t projKey     = 0;
+		uint8_t wasEncrypted = 0;
+		uint8_t isUTF8       = 0;
+		uint8_t padding[2]   = {};
+	};
+
+	static void SetDirectory(const std::filesystem::path& directory)
+	{
+		s_directory = directory;
+
+		if (!s_directory.empty())
+			CheckAndCreateDir(s_directory);
+	}
+
+	static bool Enabled()
+	{
+		return !s_directory.empty();
+	}
+
+	// 64 bit FNV-1a hash of the source data, the file type, the seed indices and the project key
+	static uint64_t Key(const uint8_t* pData, const uint32_t& size, const WolfFileType& fileType, const SeedIncides& seedIndices, const uint32_t& projKey)
+	{
+		uint64_t hash = FNV_OFFSET_BASIS;
+
+		const auto mix = [&hash](const void* pBytes, const std::size_t& count) {
+			const uint8_t* pCur = static_cast<const uint8_t*>(pBytes);
+			for (std::size_t i = 0; i < count; i++)
+				hash = (hash ^ pCur[i]) * FNV_PRIME;
+		};
+
+		const uint32_t type = static_cast<uint32_t>(fileType);
+		mix(&type, sizeof(type));
+		mix(seedIndices.data(), seedIndices.size());
+		mix(&projKey, sizeof(projKey));
+		mix(pData, size);
+
+		return hash;
+	}
+
+	// Maps the entry for the key into the reader, returns the stored decoder state on success.
+	// The reader is left untouched if there is no valid entry.
+	static std::optional<Trailer> Open(FileReader& reader, const uint64_t& key)
+	{
+		const std::filesystem::path entryPath = getEntryPath(key);
+
+		std::error_code ec;
+		const std::uintmax_t fileSize = std::filesystem::file_size(entryPath, ec);
+
+		if (ec || fileSize < sizeof(Trailer) || fileSize > UINT32_MAX)
+			return std::nullopt;
+
+		const uint32_t dataSize = static_cast<uint32_t>(fileSize - sizeof(Trailer));
+
+		Trailer trailer;
+		{
+			std::ifstream in(entryPath, std::ios::binary);
+			in.seekg(dataSize);
+			in.read(reinterpret_cast<char*>(&trailer), sizeof(Trailer));
+
+			if (!in || trailer.magic != MAGIC || trailer.version != VERSION || trailer.key != key || trailer.offset > dataSize)
+				return std::nullopt;
+		}
+
+		reader.Open(entryPath);
+		reader.Limit(dataSize);
+		reader.Seek(trailer.offset);
+
+		return trailer;
+	}
+
+	// Failing to write an entry is not fatal, the file is simply decoded again on the next run
+	static void Store(const uint64_t& key, const uint8_t* pData, const uint32_t& size, Trailer trailer)
+	{
+		trailer.key = key;
+
+		try
+		{
+			FileWriter writer(getEntryPath(key));
+			writer.WriteBytes(pData, size);
+			writer.Write(trailer);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << std::format("Warning: Failed to write decode cache entry: {}", e.what()) << std::endl;
+		}
+	}
+
+private:
+	static std::filesystem::path getEntryPath(const uint64_t& key)
+	{
+		return s_directory / std::format("{:016x}.wdc", key);
+	}
+
+private:
+	static constexpr uint32_t MAGIC            = 0x43445457; // "WTDC"
+	static constexpr uint32_t VERSION          = 1;
+	static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325;
+	static constexpr uint64_t FNV_PRIME        = 0x100000001b3;
+
+	inline static std::filesystem::path s_directory = "";
+};
@@ -0,0 +1,955 @@
+/*
+ *  File: DxArchive.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "../WolfCrypt/WolfDxArcKey.hpp"
+#include "FileAccess.hpp"
+#include "FileCoder.hpp"
+#include "Parallel.hpp"
+#include "StringConv.hpp"
+#include "Types.hpp"
+#include "WolfRPGException.hpp"
+#include "WolfRPGUtils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cwctype>
+#include <array>
+#include <bit>
+#include <filesystem>
+#include <format>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Reader for DX archives (.wolf files), supports the archive versions 5 and 6.
+// The archive is mapped and only its header block is decrypted up front, entries are decrypted and decompressed on demand.
+// Encrypted archives require the 12 byte key of the game, it is derived from Game.dat (see DeriveKey) or set explicitly (see SetKey).
+// Unencrypted archives are detected automatically.
+class DxArchive
+{
+public:
+	static constexpr uint32_t KEY_SIZE = 12;
+
+	struct Entry
+	{
+		// Path inside of the archive, directories are separated by '/'
+		tString path        = TEXT("");
+		uint64_t dataOffset = 0;
+		uint64_t size       = 0;
+		uint64_t pressSize  = 0;
+		bool compressed     = false;
+	};
+
+	using Entries = std::vector<Entry>;
+
+	explicit DxArchive(const std::filesystem::path& filePath) :
+		m_filePath(filePath),
+		m_reader(filePath)
+	{
+		m_pData = m_reader.Get();
+		// Archives can exceed 4 GiB, the data is accessed through the mapping of the whole file
+		m_size  = m_reader.GetMappedSize();
+
+		readHeader();
+	}
+
+	DISABLE_COPY_MOVE(DxArchive)
+
+	// Raw key bytes, i.e., the key after the DX library key string conversion (see KeyFromString).
+	// An explicitly set key takes precedence over the key derived from Game.dat.
+	static void SetKey(const Bytes& key)
+	{
+		if (!key.empty() && key.size() != KEY_SIZE)
+			throw WolfRPGException(std::format("{}Invalid archive key size {}, expected {} bytes", ERROR_TAG, key.size(), KEY_SIZE));
+
+		s_key         = key;
+		s_explicitKey = !key.empty();
+	}
+
+	// Derives the key from the Game.dat of the game unless a key was set explicitly.
+	// Game.dat is searched for in the data folder and in the game folder, without it only unencrypted archives can be read.
+	static void DeriveKey(const std::filesystem::path& dataPath)
+	{
+		if (s_explicitKey) return;
+
+		s_key = {};
+
+		for (const std::filesystem::path& gameDatPath : { dataPath / "BasicData" / "Game.dat", dataPath / "Game.dat", dataPath.parent_path() / "Game.dat" })
+		{
+			if (!std::filesystem::is_regular_file(gameDatPath)) continue;
+
+			FileReader reader(gameDatPath);
+			s_key = KeyFromGameDat(Bytes(reader.Get(), reader.Get() + reader.GetSize()));
+
+			if (!s_key.empty()) return;
+		}
+	}
+
+	// Key string of the game (see wolf::crypt::dxarckey::v2::calcKey) converted to the archive key, empty if Game.dat is not encrypted
+	static Bytes KeyFromGameDat(const Bytes& gameDat)
+	{
+		if (gameDat.size() <= GAME_DAT_HEADER_SIZE) return {};
+
+		try
+		{
+			return KeyFromString(wolf::crypt::dxarckey::v2::calcKey(gameDat));
+		}
+		catch (const std::exception&)
+		{
+			// The data does not fit the key derivation, i.e., the file is not encrypted this way
+			return {};
+		}
+	}
+
+	// Key string conversion of the DX library, the null terminated string is repeated (or cut) to the key size and scrambled
+	static Bytes KeyFromString(const Bytes& keyString)
+	{
+		const std::size_t length = std::find(keyString.begin(), keyString.end(), 0) - keyString.begin();
+
+		Bytes key(KEY_SIZE);
+		for (std::size_t i = 0; i < KEY_SIZE; i++)
+			key[i] = (length == 0) ? 0xAA : keyString[i % length];
+
+		key[0]  = ~key[0];
+		key[1]  = std::rotl(key[1], 4);
+		key[2]  = key[2] ^ 0x8A;
+		key[3]  = ~std::rotl(key[3], 4);
+		key[4]  = ~key[4];
+		key[5]  = key[5] ^ 0xAC;
+		key[6]  = ~key[6];
+		key[7]  = ~std::rotr(key[7], 3);
+		key[8]  = std::rotr(key[8], 5);
+		key[9]  = key[9] ^ 0x7F;
+		key[10] = std::rotl(key[10], 4) ^ 0xD6;
+		key[11] = key[11] ^ 0xCC;
+
+		return key;
+	}
+
+	const Entries& GetEntries() const
+	{
+		return m_entries;
+	}
+
+	// Case insensitive lookup, returns nullptr if the archive does not contain the file
+	const Entry* Find(const tString& path) const
+	{
+		auto it = m_index.find(normalize(path));
+		return (it == m_index.end()) ? nullptr : &m_entries[it->second];
+	}
+
+	Bytes Extract(const Entry& entry) const
+	{
+		const uint8_t* pStored = stored(entry);
+
+		Bytes data(pStored, pStored + StoredSize(entry));
+		keyConv(m_key, data.data(), data.size(), entry.size);
+
+		if (!entry.compressed)
+			return data;
+
+		return decode(data, entry);
+	}
+
+	// Extracts the entries in parallel, the result has the same order as the input
+	std::vector<Bytes> Extract(const std::vector<const Entry*>& entries) const
+	{
+		std::vector<Bytes> results(entries.size());
+
+		ParallelFor(entries.size(), [&](const std::size_t& i) {
+			results[i] = Extract(*entries[i]);
+		});
+
+		return results;
+	}
+
+	static uint64_t StoredSize(const Entry& entry)
+	{
+		return entry.compressed ? entry.pressSize : entry.size;
+	}
+
+private:
+	// Data of the entry as it is stored in the archive, i.e., still encrypted and compressed
+	const uint8_t* stored(const Entry& entry) const
+	{
+		const uint64_t storedSize = StoredSize(entry);
+		const uint64_t start      = m_dataStart + entry.dataOffset;
+
+		if (start > m_size || storedSize > m_size - start)
+			throw WolfRPGException(std::format(L"{}Entry {} exceeds the archive {}", ERROR_TAGW, entry.path, m_filePath.wstring()));
+
+		return m_pData + start;
+	}
+
+	void readHeader()
+	{
+		if (m_size < HEADER_SIZE_V5)
+			throw WolfRPGException(std::format(L"{}File is too small to be an archive: {}", ERROR_TAGW, m_filePath.wstring()));
+
+		// The header is encrypted like everything else, the signature tells whether the key is correct
+		if ((s_key.size() == KEY_SIZE) && ((m_pData[0] ^ s_key[0]) == 'D') && ((m_pData[1] ^ s_key[1]) == 'X'))
+			m_key = s_key;
+		else if (m_pData[0] != 'D' || m_pData[1] != 'X')
+			throw WolfRPGException(std::format(L"{}Not a DX archive or wrong key (derived from Game.dat or set with --dxa_key): {}", ERROR_TAGW, m_filePath.wstring()));
+
+		Bytes header(m_pData, m_pData + std::min<uint64_t>(m_size, HEADER_SIZE_V6));
+		keyConv(m_key, header.data(), header.size(), 0);
+
+		m_version = get<uint16_t>(header, 2);
+
+		uint64_t headSize  = 0;
+		uint64_t nameTable = 0;
+		uint64_t fileTable = 0;
+		uint64_t dirTable  = 0;
+
+		if (m_version == 5)
+		{
+			headSize    = get<uint32_t>(header, 4);
+			m_dataStart = get<uint32_t>(header, 8);
+			nameTable   = get<uint32_t>(header, 12);
+			fileTable   = get<uint32_t>(header, 16);
+			dirTable    = get<uint32_t>(header, 20);
+			m_codePage  = get<uint32_t>(header, 24);
+		}
+		else if (m_version == 6)
+		{
+			if (header.size() < HEADER_SIZE_V6)
+				throw WolfRPGException(std::format(L"{}Archive header is truncated: {}", ERROR_TAGW, m_filePath.wstring()));
+
+			headSize    = get<uint32_t>(header, 4);
+			m_dataStart = get<uint64_t>(header, 8);
+			nameTable   = get<uint64_t>(header, 16);
+			fileTable   = get<uint64_t>(header, 24);
+			dirTable    = get<uint64_t>(header, 32);
+			m_codePage  = static_cast<uint32_t>(get<uint64_t>(header, 40));
+		}
+		else
+			throw WolfRPGException(std::format(L"{}Unsupported archive version {} in {}", ERROR_TAGW, m_version, m_filePath.wstring()));
+
+		if (nameTable > m_size || headSize > m_size - nameTable)
+			throw WolfRPGException(std::format(L"{}Archive header block exceeds the file: {}", ERROR_TAGW, m_filePath.wstring()));
+
+		// Names, file heads and directories are stored in one block, the table offsets are relative to its start
+		m_block.assign(m_pData + nameTable, m_pData + nameTable + headSize);
+		keyConv(m_key, m_block.data(), m_block.size(), 0);
+
+		m_fileTable = fileTable;
+		m_dirTable  = dirTable;
+
+		std::unordered_set<uint64_t> visited;
+		readDirectory(0, TEXT(""), visited);
+
+		m_index.reserve(m_entries.size());
+		for (std::size_t i = 0; i < m_entries.size(); i++)
+			m_index.emplace(normalize(m_entries[i].path), i);
+
+		// The block is only needed to build the directory
+		m_block = {};
+	}
+
+	void readDirectory(const uint64_t& dirOffset, const tString& prefix, std::unordered_set<uint64_t>& visited)
+	{
+		// Guard against malformed archives whose directories form a cycle
+		if (!visited.insert(dirOffset).second)
+			throw WolfRPGException(std::format(L"{}Recursive directory {} in {}", ERROR_TAGW, prefix, m_filePath.wstring()));
+
+		const bool v6          = (m_version >= 6);
+		const uint64_t dirAddr = m_dirTable + dirOffset;
+
+		const uint64_t fileHeadNum  = v6 ? get<uint64_t>(m_block, dirAddr + 16) : get<uint32_t>(m_block, dirAddr + 8);
+		const uint64_t fileHeadAddr = v6 ? get<uint64_t>(m_block, dirAddr + 24) : get<uint32_t>(m_block, dirAddr + 12);
+
+		const uint64_t headSize = v6 ? FILE_HEAD_SIZE_V6 : FILE_HEAD_SIZE_V5;
+
+		for (uint64_t i = 0; i < fileHeadNum; i++)
+		{
+			const uint64_t addr = m_fileTable + fileHeadAddr + i * headSize;
+
+			const uint64_t nameAddr   = v6 ? get<uint64_t>(m_block, addr) : get<uint32_t>(m_block, addr);
+			const uint64_t attributes = v6 ? get<uint64_t>(m_block, addr + 8) : get<uint32_t>(m_block, addr + 4);
+			const uint64_t dataAddr   = v6 ? get<uint64_t>(m_block, addr + 40) : get<uint32_t>(m_block, addr + 32);
+			const uint64_t dataSize   = v6 ? get<uint64_t>(m_block, addr + 48) : get<uint32_t>(m_block, addr + 36);
+			const uint64_t pressSize  = v6 ? get<uint64_t>(m_block, addr + 56) : get<uint32_t>(m_block, addr + 40);
+
+			const tString path = prefix + readName(nameAddr);
+
+			if (attributes & ATTRIBUTE_DIRECTORY)
+			{
+				readDirectory(dataAddr, path + TEXT("/"), visited);
+				continue;
+			}
+
+			const bool compressed = v6 ? (pressSize != NO_PRESS_V6) : (pressSize != NO_PRESS_V5);
+			m_entries.push_back({ path, dataAddr, dataSize, compressed ? pressSize : 0, compressed });
+		}
+	}
+
+	// Name entry: length in 4 byte units, parity, upper case name, original name
+	tString readName(const uint64_t& nameAddr) const
+	{
+		const uint64_t length = static_cast<uint64_t>(get<uint16_t>(m_block, nameAddr)) * 4;
+		const uint64_t start  = nameAddr + 4 + length;
+
+		if (start + length > m_block.size())
+			throw WolfRPGException(std::format(L"{}Invalid file name entry in {}", ERROR_TAGW, m_filePath.wstring()));
+
+		const uint8_t* pName = m_block.data() + start;
+		const uint8_t* pEnd  = std::find(pName, pName + length, 0);
+
+		if (m_codePage == CODE_PAGE_UTF8)
+			return ToUTF16(std::string(pName, pEnd));
+
+		Bytes name(pName, pEnd);
+		name.push_back(0);
+
+		return FileCoder::DecodeSJIS(name);
+	}
+
+	// Position dependent XOR with the archive key, the position of file data is its uncompressed size.
+	// Nothing is done for an empty key, i.e., for unencrypted archives.
+	static void keyConv(const Bytes& key, uint8_t* pData, const std::size_t& size, const uint64_t& position)
+	{
+		if (key.empty()) return;
+
+		std::size_t k = position % KEY_SIZE;
+		for (std::size_t i = 0; i < size; i++)
+		{
+			pData[i] ^= key[k];
+			k = (k + 1 == KEY_SIZE) ? 0 : k + 1;
+		}
+	}
+
+	// LZ decompression of the DX library: destination size, source size (including this header), escape byte.
+	// The escape byte is followed by a literal escape byte or by a back reference (length code, optional length extension, offset).
+	Bytes decode(const Bytes& src, const Entry& entry) const
+	{
+		if (src.size() < LZ_HEADER_SIZE)
+			throw WolfRPGException(std::format(L"{}Compressed entry {} is truncated", ERROR_TAGW, entry.path));
+
+		const uint32_t destSize = get<uint32_t>(src, 0);
+		const uint32_t srcSize  = get<uint32_t>(src, 4);
+		const uint8_t keyCode   = src[8];
+
+		if (destSize != entry.size || srcSize > src.size() || srcSize < LZ_HEADER_SIZE)
+			throw WolfRPGException(std::format(L"{}Compressed entry {} has an invalid header", ERROR_TAGW, entry.path));
+
+		Bytes dest(destSize);
+
+		const uint8_t* pSrc    = src.data() + LZ_HEADER_SIZE;
+		const uint8_t* pSrcEnd = src.data() + srcSize;
+		std::size_t d          = 0;
+
+		const auto fail = [&]() {
+			return WolfRPGException(std::format(L"{}Compressed entry {} is corrupted", ERROR_TAGW, entry.path));
+		};
+
+		while (pSrc < pSrcEnd)
+		{
+			if (*pSrc != keyCode)
+			{
+				if (d >= destSize) throw fail();
+				dest[d++] = *pSrc++;
+				continue;
+			}
+
+			if (pSrcEnd - pSrc < 2) throw fail();
+
+			if (pSrc[1] == keyCode)
+			{
+				if (d >= destSize) throw fail();
+				dest[d++] = keyCode;
+				pSrc += 2;
+				continue;
+			}
+
+			uint32_t code = pSrc[1];
+			if (code > keyCode) code--;
+			pSrc += 2;
+
+			uint32_t length = code >> 3;
+			if (code & 0x4)
+			{
+				if (pSrc >= pSrcEnd) throw fail();
+				length |= static_cast<uint32_t>(*pSrc++) << 5;
+			}
+			length += LZ_MIN_LENGTH;
+
+			const uint32_t offsetBytes = (code & 0x3) + 1;
+			if (offsetBytes > 3 || pSrcEnd - pSrc < offsetBytes) throw fail();
+
+			uint32_t offset = 0;
+			for (uint32_t b = 0; b < offsetBytes; b++)
+				offset |= static_cast<uint32_t>(pSrc[b]) << (8 * b);
+			pSrc += offsetBytes;
+			offset++;
+
+			if (offset > d || length > destSize - d) throw fail();
+
+			// The source may overlap the destination, i.e., copy byte by byte
+			for (uint32_t b = 0; b < length; b++, d++)
+				dest[d] = dest[d - offset];
+		}
+
+		if (d != destSize) throw fail();
+
+		return dest;
+	}
+
+	template<typename T>
+	T get(const Bytes& data, const uint64_t& offset) const
+	{
+		if (offset > data.size() || sizeof(T) > data.size() - offset)
+			throw WolfRPGException(std::format(L"{}Read outside of the archive header in {}", ERROR_TAGW, m_filePath.wstring()));
+
+		T value;
+		std::memcpy(&value, data.data() + offset, sizeof(T));
+		return value;
+	}
+
+	static tString normalize(tString path)
+	{
+		std::replace(path.begin(), path.end(), TEXT('\\'), TEXT('/'));
+		std::transform(path.begin(), path.end(), path.begin(), [](const wchar_t& c) { return static_cast<wchar_t>(std::towlower(c)); });
+		return path;
+	}
+
+private:
+	static constexpr uint64_t GAME_DAT_HEADER_SIZE = 31;
+	static constexpr uint64_t HEADER_SIZE_V5       = 28;
+	static constexpr uint64_t HEADER_SIZE_V6       = 48;
+	static constexpr uint64_t FILE_HEAD_SIZE_V5    = 44;
+	static constexpr uint64_t FILE_HEAD_SIZE_V6    = 64;
+	static constexpr uint64_t NO_PRESS_V5          = 0xFFFFFFFF;
+	static constexpr uint64_t NO_PRESS_V6          = 0xFFFFFFFFFFFFFFFF;
+	static constexpr uint64_t DIRECTORY_SIZE_V6    = 32;
+	static constexpr uint64_t ATTRIBUTE_DIRECTORY  = 0x10;
+	static constexpr uint64_t ATTRIBUTE_ARCHIVE    = 0x20;
+	static constexpr uint32_t CODE_PAGE_SJIS       = 932;
+	static constexpr uint32_t CODE_PAGE_UTF8       = 65001;
+	static constexpr uint32_t LZ_HEADER_SIZE       = 9;
+	static constexpr uint32_t LZ_MIN_LENGTH        = 4;
+	static constexpr uint32_t LZ_MAX_LENGTH        = ((0xFF << 5) | 0x1F) + LZ_MIN_LENGTH;
+
+	std::filesystem::path m_filePath;
+	FileReader m_reader;
+
+	const uint8_t* m_pData = nullptr;
+	uint64_t m_size        = 0;
+
+	uint16_t m_version   = 0;
+	uint32_t m_codePage  = 0;
+	uint64_t m_dataStart = 0;
+	uint64_t m_fileTable = 0;
+	uint64_t m_dirTable  = 0;
+	Bytes m_key          = {};
+
+	Bytes m_block                                    = {};
+	Entries m_entries                                = {};
+	std::unordered_map<tString, std::size_t> m_index = {};
+
+	inline static Bytes s_key        = {};
+	inline static bool s_explicitKey = false;
+
+	friend class DxArchiveWriter;
+};
+
+// Writer for DX archives of version 6, encrypted with the key set via DxArchive::SetKey (unencrypted if no key is set).
+// Files are collected in memory, Finish compresses and encrypts them in parallel and writes the archive in one sequential pass.
+class DxArchiveWriter
+{
+public:
+	// Names are stored in the code page of the game unless a source archive is added (see AddArchive)
+	explicit DxArchiveWriter(const std::filesystem::path& filePath) :
+		m_filePath(filePath),
+		m_key(DxArchive::s_key),
+		m_codePage(FileCoder::IsUTF8() ? DxArchive::CODE_PAGE_UTF8 : DxArchive::CODE_PAGE_SJIS)
+	{
+	}
+
+	DISABLE_COPY_MOVE(DxArchiveWriter)
+
+	// Adds a file to the archive, directories in the path are separated by '/'.
+	// Adding a path a second time replaces the previous file.
+	void Add(const tString& path, Bytes data)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto [it, inserted] = m_index.emplace(DxArchive::normalize(path), m_files.size());
+		if (!inserted)
+		{
+			m_files[it->second].data = std::move(data);
+			return;
+		}
+
+		File& file = m_files.emplace_back();
+		file.path  = path;
+		file.data  = std::move(data);
+	}
+
+	// Carries the files of an existing archive over into the new one, files added to this writer take precedence.
+	// Files are copied as they are stored if both archives use the same key, i.e., without decompressing them.
+	// The new archive takes over the code page of the first source archive, i.e., its names stay representable.
+	// The files are stored below the prefix, e.g., "BasicData/" to merge the content of BasicData.wolf.
+	void AddArchive(const std::filesystem::path& archivePath, const tString& prefix = TEXT(""))
+	{
+		m_sources.push_back({ std::make_unique<DxArchive>(archivePath), prefix });
+
+		if (m_sources.size() == 1)
+			m_codePage = (m_sources.front().pArchive->m_codePage == DxArchive::CODE_PAGE_UTF8) ? DxArchive::CODE_PAGE_UTF8 : DxArchive::CODE_PAGE_SJIS;
+	}
+
+	void Finish()
+	{
+		addSourceFiles();
+
+		// Compression and encryption are independent for every file
+		ParallelFor(m_files.size(), [&](const std::size_t& i) {
+			prepare(m_files[i]);
+		});
+
+		uint64_t dataSize = 0;
+		for (File& file : m_files)
+		{
+			file.dataAddress = dataSize;
+			dataSize += DxArchive::StoredSize(file.entry);
+		}
+
+		Bytes block = buildBlock();
+
+		Bytes header(DxArchive::HEADER_SIZE_V6, 0);
+		put<uint16_t>(header, 0, static_cast<uint16_t>('D' | ('X' << 8)));
+		put<uint16_t>(header, 2, 6);
+		put<uint32_t>(header, 4, static_cast<uint32_t>(block.size()));
+		put<uint64_t>(header, 8, DxArchive::HEADER_SIZE_V6);
+		put<uint64_t>(header, 16, DxArchive::HEADER_SIZE_V6 + dataSize);
+		put<uint64_t>(header, 24, m_fileTable);
+		put<uint64_t>(header, 32, m_dirTable);
+		put<uint64_t>(header, 40, m_codePage);
+
+		DxArchive::keyConv(m_key, header.data(), header.size(), 0);
+		DxArchive::keyConv(m_key, block.data(), block.size(), 0);
+
+		{
+			FileWriter writer(m_filePath);
+			writer.WriteBytesVec(header);
+
+			for (const File& file : m_files)
+			{
+				if (file.pSource && file.data.empty())
+					writer.WriteBytes(file.pSource->stored(*file.pEntry), DxArchive::StoredSize(file.entry));
+				else
+					writer.WriteBytesVec(file.data);
+			}
+
+			writer.WriteBytesVec(block);
+
+			// The source archives have to be released before the writer replaces the target, it might be one of them
+			m_sources.clear();
+		}
+
+		m_files.clear();
+		m_index.clear();
+	}
+
+private:
+	struct File
+	{
+		tString path = TEXT("");
+		Bytes data   = {};
+
+		// Set for files carried over from a source archive
+		const DxArchive* pSource       = nullptr;
+		const DxArchive::Entry* pEntry = nullptr;
+
+		// Sizes and compression of the stored data
+		DxArchive::Entry entry = {};
+		uint64_t dataAddress   = 0;
+	};
+
+	struct Source
+	{
+		std::unique_ptr<DxArchive> pArchive = nullptr;
+		tString prefix                      = TEXT("");
+	};
+
+	struct Directory
+	{
+		tString name                        = TEXT("");
+		std::size_t parent                  = 0;
+		std::map<tString, std::size_t> dirs = {};
+		std::vector<std::size_t> files      = {};
+		uint64_t headAddress                = 0;
+		uint64_t childAddress               = 0;
+	};
+
+	void addSourceFiles()
+	{
+		for (const Source& source : m_sources)
+		{
+			for (const DxArchive::Entry& entry : source.pArchive->GetEntries())
+			{
+				const tString path = source.prefix + entry.path;
+
+				if (!m_index.emplace(DxArchive::normalize(path), m_files.size()).second) continue;
+
+				File& file   = m_files.emplace_back();
+				file.path    = path;
+				file.pSource = source.pArchive.get();
+				file.pEntry  = &entry;
+			}
+		}
+	}
+
+	void prepare(File& file)
+	{
+		if (file.pSource)
+		{
+			// Same key, the stored data can be copied as is
+			if (file.pSource->m_key == m_key)
+			{
+				file.entry = *file.pEntry;
+				return;
+			}
+
+			file.data = file.pSource->Extract(*file.pEntry);
+		}
+
+		file.entry.size       = file.data.size();
+		file.entry.compressed = false;
+
+		Bytes packed = encode(file.data);
+		if (!packed.empty())
+		{
+			file.data             = std::move(packed);
+			file.entry.pressSize  = file.data.size();
+			file.entry.compressed = true;
+		}
+
+		DxArchive::keyConv(m_key, file.data.data(), file.data.size(), file.entry.size);
+	}
+
+	// Block with the name table, the file table and the directory table.
+	// Every directory lists its subdirectories followed by its files, the heads of the children of a directory are consecutive.
+	Bytes buildBlock()
+	{
+		std::vector<Directory> dirs(1);
+
+		for (std::size_t i = 0; i < m_files.size(); i++)
+		{
+			const tString& path = m_files[i].path;
+
+			std::size_t dir   = 0;
+			std::size_t start = 0;
+			for (std::size_t sep = path.find(TEXT('/')); sep != tString::npos; sep = path.find(TEXT('/'), start))
+			{
+				const tString name = path.substr(start, sep - start);
+				start              = sep + 1;
+
+				const auto [it, inserted] = dirs[dir].dirs.emplace(DxArchive::normalize(name), dirs.size());
+				const std::size_t sub     = it->second;
+
+				if (inserted)
+					dirs.push_back({ name, dir });
+
+				dir = sub;
+			}
+
+			dirs[dir].files.push_back(i);
+		}
+
+		// Breadth first order, the root directory and its head come first
+		std::vector<std::size_t> order;
+		std::queue<std::size_t> pending;
+		pending.push(0);
+
+		while (!pending.empty())
+		{
+			const std::size_t dir = pending.front();
+			pending.pop();
+			order.push_back(dir);
+
+			for (const auto& [key, sub] : dirs[dir].dirs)
+				pending.push(sub);
+		}
+
+		std::vector<uint64_t> dirAddress(dirs.size());
+		uint64_t headAddress = DxArchive::FILE_HEAD_SIZE_V6;
+
+		for (std::size_t i = 0; i < order.size(); i++)
+		{
+			Directory& dir = dirs[order[i]];
+
+			dirAddress[order[i]] = i * DxArchive::DIRECTORY_SIZE_V6;
+			dir.childAddress     = headAddress;
+
+			for (const auto& [key, sub] : dir.dirs)
+			{
+				dirs[sub].headAddress = headAddress;
+				headAddress += DxArchive::FILE_HEAD_SIZE_V6;
+			}
+
+			headAddress += dir.files.size() * DxArchive::FILE_HEAD_SIZE_V6;
+		}
+
+		Bytes names = nameEntry(TEXT(""));
+		Bytes fileTable(headAddress, 0);
+		Bytes dirTable(order.size() * DxArchive::DIRECTORY_SIZE_V6, 0);
+
+		const auto addHead = [&](const uint64_t& address, const tString& name, const uint64_t& attributes, const uint64_t& dataAddress, const DxArchive::Entry& entry) {
+			put<uint64_t>(fileTable, address, names.size());
+			put<uint64_t>(fileTable, address + 8, attributes);
+			put<uint64_t>(fileTable, address + 40, dataAddress);
+			put<uint64_t>(fileTable, address + 48, entry.size);
+			put<uint64_t>(fileTable, address + 56, entry.compressed ? entry.pressSize : DxArchive::NO_PRESS_V6);
+
+			const Bytes entryName = nameEntry(name);
+			names.insert(names.end(), entryName.begin(), entryName.end());
+		};
+
+		addHead(0, TEXT(""), DxArchive::ATTRIBUTE_DIRECTORY, 0, {});
+
+		for (const std::size_t& d : order)
+		{
+			const Directory& dir = dirs[d];
+			uint64_t address     = dir.childAddress;
+
+			for (const auto& [key, sub] : dir.dirs)
+			{
+				addHead(address, dirs[sub].name, DxArchive::ATTRIBUTE_DIRECTORY, dirAddress[sub], {});
+				address += DxArchive::FILE_HEAD_SIZE_V6;
+			}
+
+			for (const std::size_t& f : dir.files)
+			{
+				const File& file = m_files[f];
+				addHead(address, file.path.substr(file.path.rfind(TEXT('/')) + 1), DxArchive::ATTRIBUTE_ARCHIVE, file.dataAddress, file.entry);
+				address += DxArchive::FILE_HEAD_SIZE_V6;
+			}
+
+			const uint64_t dirOffset = dirAddress[d];
+			put<uint64_t>(dirTable, dirOffset, dir.headAddress);
+			put<uint64_t>(dirTable, dirOffset + 8, (d == 0) ? DxArchive::NO_PRESS_V6 : dirAddress[dir.parent]);
+			put<uint64_t>(dirTable, dirOffset + 16, dir.dirs.size() + dir.files.size());
+			put<uint64_t>(dirTable, dirOffset + 24, dir.childAddress);
+		}
+
+		m_fileTable = names.size();
+		m_dirTable  = names.size() + fileTable.size();
+
+		Bytes block = std::move(names);
+		block.insert(block.end(), fileTable.begin(), fileTable.end());
+		block.insert(block.end(), dirTable.begin(), dirTable.end());
+
+		return block;
+	}
+
+	// Name entry: length in 4 byte units, parity (byte sum of the upper case name), upper case name, original name
+	Bytes nameEntry(const tString& name) const
+	{
+		if (name.empty()) return Bytes(4, 0);
+
+		const bool utf8 = (m_codePage == DxArchive::CODE_PAGE_UTF8);
+
+		Bytes original;
+		if (utf8)
+		{
+			const std::string str = ToUTF8(name);
+			original.assign(str.begin(), str.end());
+		}
+		else
+			original = FileCoder::EncodeSJIS(name);
+
+		if (original.empty() || original.back() != 0)
+			original.push_back(0);
+
+		const std::size_t length = (original.size() + 3) / 4;
+		original.resize(length * 4, 0);
+
+		// Only ASCII letters are converted, the second byte of a Shift-JIS character is left untouched.
+		// All bytes of multibyte UTF-8 characters are outside of the ASCII range.
+		Bytes upper = original;
+		for (std::size_t i = 0; i < upper.size(); i++)
+		{
+			const uint8_t& c = upper[i];
+			if (!utf8 && ((c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC)))
+				i++;
+			else if (c >= 'a' && c <= 'z')
+				upper[i] = static_cast<uint8_t>(c - 'a' + 'A');
+		}
+
+		uint16_t parity = 0;
+		for (const uint8_t& c : upper)
+			parity += c;
+
+		Bytes entry(4, 0);
+		put<uint16_t>(entry, 0, static_cast<uint16_t>(length));
+		put<uint16_t>(entry, 2, parity);
+		entry.insert(entry.end(), upper.begin(), upper.end());
+		entry.insert(entry.end(), original.begin(), original.end());
+
+		return entry;
+	}
+
+	// Counterpart of DxArchive::decode, uses hash chains to find back references.
+	// Returns an empty vector if the data does not get smaller.
+	static Bytes encode(const Bytes& src)
+	{
+		const std::size_t size = src.size();
+		if (size <= LZ_MIN_MATCH_SIZE || size > UINT32_MAX) return {};
+
+		// The least frequent byte is used as escape code, as a literal it takes two bytes
+		std::array<std::size_t, 256> counts = {};
+		for (const uint8_t& c : src)
+			counts[c]++;
+
+		const uint8_t keyCode = static_cast<uint8_t>(std::min_element(counts.begin(), counts.end()) - counts.begin());
+
+		Bytes dst(DxArchive::LZ_HEADER_SIZE, 0);
+		dst.reserve(size);
+
+		std::vector<uint32_t> heads(std::size_t(1) << LZ_HASH_BITS, LZ_NONE);
+		std::vector<uint32_t> chain(LZ_WINDOW_SIZE, LZ_NONE);
+
+		const auto hash = [&](const std::size_t& pos) {
+			uint32_t value;
+			std::memcpy(&value, src.data() + pos, sizeof(uint32_t));
+			return (value * 2654435761u) >> (32 - LZ_HASH_BITS);
+		};
+
+		const auto insert = [&](const std::size_t& pos) {
+			if (pos + DxArchive::LZ_MIN_LENGTH > size) return;
+
+			const uint32_t h                  = hash(pos);
+			chain[pos & (LZ_WINDOW_SIZE - 1)] = heads[h];
+			heads[h]                          = static_cast<uint32_t>(pos);
+		};
+
+		std::size_t pos = 0;
+		while (pos < size)
+		{
+			uint32_t bestLength = 0;
+			uint32_t bestOffset = 0;
+
+			if (pos + DxArchive::LZ_MIN_LENGTH <= size)
+			{
+				const std::size_t maxLength = std::min<std::size_t>(DxArchive::LZ_MAX_LENGTH, size - pos);
+
+				uint32_t candidate = heads[hash(pos)];
+				for (uint32_t depth = 0; candidate != LZ_NONE && pos - candidate <= LZ_WINDOW_SIZE && depth < LZ_MAX_CHAIN; depth++)
+				{
+					uint32_t length = 0;
+					while (length < maxLength && src[candidate + length] == src[pos + length])
+						length++;
+
+					if (length > bestLength)
+					{
+						bestLength = length;
+						bestOffset = static_cast<uint32_t>(pos - candidate);
+						if (length == maxLength) break;
+					}
+
+					// Entries of the chain can be overwritten by newer positions, the chain always has to go back
+					const uint32_t next = chain[candidate & (LZ_WINDOW_SIZE - 1)];
+					if (next == LZ_NONE || next >= candidate) break;
+					candidate = next;
+				}
+			}
+
+			const uint32_t offset      = bestOffset - 1;
+			const uint32_t offsetBytes = (offset < 0x100) ? 1 : (offset < 0x10000) ? 2 : 3;
+			const uint32_t length      = bestLength - DxArchive::LZ_MIN_LENGTH;
+			const bool extended        = (length > 0x1F);
+
+			if (bestLength < DxArchive::LZ_MIN_LENGTH || 2 + offsetBytes + (extended ? 1 : 0) >= bestLength)
+			{
+				dst.push_back(src[pos]);
+				if (src[pos] == keyCode)
+					dst.push_back(keyCode);
+
+				insert(pos++);
+			}
+			else
+			{
+				uint32_t code = ((length & 0x1F) << 3) | (extended ? 0x4 : 0x0) | (offsetBytes - 1);
+				if (code >= keyCode) code++;
+
+				dst.push_back(keyCode);
+				dst.push_back(static_cast<uint8_t>(code));
+
+				if (extended)
+					dst.push_back(static_cast<uint8_t>(length >> 5));
+
+				for (uint32_t b = 0; b < offsetBytes; b++)
+					dst.push_back(static_cast<uint8_t>(offset >> (8 * b)));
+
+				for (const std::size_t end = pos + bestLength; pos < end; pos++)
+					insert(pos);
+			}
+
+			if (dst.size() >= size) return {};
+		}
+
+		put<uint32_t>(dst, 0, static_cast<uint32_t>(size));
+		put<uint32_t>(dst, 4, static_cast<uint32_t>(dst.size()));
+		dst[8] = keyCode;
+
+		return dst;
+	}
+
+	template<typename T>
+	static void put(Bytes& data, const uint64_t& offset, const T& value)
+	{
+		std::memcpy(data.data() + offset, &value, sizeof(T));
+	}
+
+private:
+	static constexpr uint32_t LZ_HASH_BITS         = 16;
+	static constexpr uint32_t LZ_WINDOW_SIZE       = 1 << 17;
+	static constexpr uint32_t LZ_MAX_CHAIN         = 32;
+	static constexpr uint32_t LZ_NONE              = 0xFFFFFFFF;
+	static constexpr std::size_t LZ_MIN_MATCH_SIZE = DxArchive::LZ_HEADER_SIZE + DxArchive::LZ_MIN_LENGTH;
+
+	std::filesystem::path m_filePath;
+	Bytes m_key;
+	uint32_t m_codePage;
+
+	std::vector<File> m_files                        = {};
+	std::unordered_map<tString, std::size_t> m_index = {};
+	std::vector<Source> m_sources                    = {};
+	std::mutex m_mutex;
+
+	uint64_t m_fileTable = 0;
+	uint64_t m_dirTable  = 0;
+};
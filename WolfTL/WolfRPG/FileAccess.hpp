@@ -32,10 +32,16 @@
 #include <sys/mman.h>
 #endif
 
+#include <algorithm>
 #include <codecvt>
 #include <exception>
 #include <filesystem>
+#include <format>
 #include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -82,9 +88,9 @@ public:
 		Open(filePath, startOffset);
 	}
 
-	FileReader(const std::vector<uint8_t>& dataVec)
+	FileReader(std::vector<uint8_t> dataVec)
 	{
-		InitData(dataVec);
+		InitData(std::move(dataVec));
 	}
 
 	// Disable copy constructor and copy assignment operator
@@ -96,19 +102,34 @@ public:
 		close();
 	}
 
-	void InitData(const std::vector<uint8_t>& dataVec)
+	void InitData(std::vector<uint8_t> dataVec)
 	{
 		close();
 
 		m_offset  = 0;
-		m_dataVec = dataVec;
+		m_dataVec = std::move(dataVec);
 		m_pData   = m_dataVec.data();
 
 		if (m_dataVec.size() > static_cast<size_t>(std::numeric_limits<uint32_t>::max()))
 			throw(FileReaderException("Data size exceeds maximum uint32_t value"));
 
-		m_size = static_cast<uint32_t>(m_dataVec.size());
-		m_init = true;
+		m_size   = static_cast<uint32_t>(m_dataVec.size());
+		m_init   = true;
+		m_mapped = false;
+	}
+
+	// Reads from data owned by someone else, the data has to outlive the reader
+	void InitView(const uint8_t* pData, const uint32_t& size)
+	{
+		close();
+
+		m_offset = 0;
+		m_dataVec.clear();
+		m_pData = const_cast<uint8_t*>(pData);
+
+		m_size   = size;
+		m_init   = true;
+		m_mapped = false;
 	}
 
 	void Open(const std::filesystem::path& filePath, const uint32_t& startOffset = 0)
@@ -121,6 +142,21 @@ public:
 		return m_offset >= m_size;
 	}
 
+	// True if the data is the unmodified content of the opened file
+	bool IsMapped() const
+	{
+		return m_mapped;
+	}
+
+	// Restricts the readable data to the first size bytes, e.g., to exclude a trailer at the end of the file
+	void Limit(const uint32_t& size)
+	{
+		if (size > m_size)
+			throw(FileReaderException("Limit: size is larger than the data size"));
+
+		m_size = size;
+	}
+
 	uint64_t ReadUInt64()
 	{
 		return read<uint64_t>();
@@ -247,6 +283,12 @@ public:
 		return m_size;
 	}
 
+	// Size of the mapped file, can exceed GetSize for files larger than 4 GiB which are accessed through Get
+	uint64_t GetMappedSize() const
+	{
+		return m_mapped ? m_mapSize : m_size;
+	}
+
 	bool IsEndOfFile()
 	{
 		return m_offset >= m_size;
@@ -271,14 +313,62 @@ public:
 		file.write(reinterpret_cast<const char*>(m_pData), m_size);
 	}
 
+	// Transfers the ownership of the current data (buffer or file mapping) to a shared object.
+	// Pointers into the data stay valid as long as the returned object is alive, even after the reader is closed.
+	std::shared_ptr<const void> Share()
+	{
+		if (!m_init)
+			throw(FileReaderException("FileWalker not initialized"));
+
+		if (m_pShared)
+			return m_pShared;
+
+		if (m_pMapView == nullptr)
+			m_pShared = std::make_shared<const std::vector<uint8_t>>(std::move(m_dataVec));
+		else
+		{
+#ifdef _WIN32
+			HANDLE pFile    = m_pFile;
+			HANDLE pFileMap = m_pFileMap;
+
+			m_pShared = std::shared_ptr<const void>(m_pMapView, [pFile, pFileMap](const void* pView) {
+				UnmapViewOfFile(pView);
+				CloseHandle(pFileMap);
+				CloseHandle(pFile);
+			});
+
+			m_pFile    = nullptr;
+			m_pFileMap = nullptr;
+#else
+			const int fd           = m_fd;
+			const std::size_t size = m_mapSize;
+
+			m_pShared = std::shared_ptr<const void>(m_pMapView, [fd, size](const void* pView) {
+				::munmap(const_cast<void*>(pView), size);
+				::close(fd);
+			});
+
+			m_fd = -1;
+#endif
+			m_pMapView = nullptr;
+		}
+
+		return m_pShared;
+	}
+
 private:
 	void open(const std::filesystem::path& filePath, const uint32_t& startOffset = 0)
 	{
 		if (!std::filesystem::exists(filePath))
 			throw(FileReaderException(L"File does not exist: " + filePath.wstring()));
 
-		// Load the file size first so it is available during opening, important for Linux mmap
-		m_size = static_cast<uint32_t>(std::filesystem::file_size(filePath));
+		// Release the previous data in case the reader is reused
+		close();
+
+		// Load the file size first so it is available during opening, important for Linux mmap.
+		// The whole file is mapped, but only the first 4 GiB can be accessed through the read functions (see GetMappedSize).
+		m_mapSize = std::filesystem::file_size(filePath);
+		m_size    = static_cast<uint32_t>(std::min<uint64_t>(m_mapSize, std::numeric_limits<uint32_t>::max()));
 
 #ifdef _WIN32
 		openWin(filePath);
@@ -288,12 +378,14 @@ private:
 
 		m_offset = startOffset;
 		m_init   = true;
+		m_mapped = true;
 	}
 
 #ifdef _WIN32
 	void openWin(const std::filesystem::path& filePath)
 	{
-		m_pFile = CreateFileW(filePath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		// FILE_SHARE_DELETE allows replacing the file while it is mapped (see FileWriter::Open)
+		m_pFile = CreateFileW(filePath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 		if (m_pFile == nullptr)
 			throw(FileReaderException(L"Failed to open file: " + filePath.wstring()));
 
@@ -322,7 +414,7 @@ private:
 		if (m_fd == -1)
 			throw FileReaderException("Failed to open file: " + filePath.string());
 
-		m_pMapView = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+		m_pMapView = ::mmap(nullptr, m_mapSize, PROT_READ, MAP_PRIVATE, m_fd, 0);
 
 		if (m_pMapView == MAP_FAILED)
 		{
@@ -343,6 +435,7 @@ private:
 #endif
 
 		m_offset = 0;
+		m_pShared.reset();
 	}
 
 #ifdef _WIN32
@@ -370,7 +463,7 @@ private:
 	void closeLinux()
 	{
 		if (m_pMapView)
-			::munmap(m_pMapView, m_size);
+			::munmap(m_pMapView, m_mapSize);
 		if (m_fd != -1)
 			::close(m_fd);
 
@@ -394,7 +487,8 @@ private:
 	}
 
 private:
-	bool m_init = false;
+	bool m_init   = false;
+	bool m_mapped = false;
 
 #ifdef _WIN32
 	HANDLE m_pFile    = nullptr;
@@ -406,10 +500,13 @@ private:
 	void* m_pMapView = nullptr;
 	uint8_t* m_pData = nullptr;
 
-	uint32_t m_offset = 0;
-	uint32_t m_size   = 0;
+	uint32_t m_offset  = 0;
+	uint32_t m_size    = 0;
+	uint64_t m_mapSize = 0;
 
 	std::vector<uint8_t> m_dataVec = {};
+
+	std::shared_ptr<const void> m_pShared = nullptr;
 };
 
 class FileWriterException : public std::exception
@@ -445,18 +542,54 @@ public:
 	FileWriter(const FileWriter&)            = delete;
 	FileWriter& operator=(const FileWriter&) = delete;
 
+	// The data is written to a temporary file which replaces the target once the writer is closed.
+	// This way the target is never truncated while it might still be mapped by a reader (e.g., when patching in place).
 	void Open(const std::filesystem::path& filePath)
 	{
-		m_file = std::fstream(filePath, std::ios::out | std::ios::binary);
+		m_filePath = filePath;
+
+		// Collect the data in memory, it is handed to the sink when the writer is closed
+		if (s_sink)
+		{
+			m_bufferMode = true;
+			m_toSink     = true;
+			m_exceptions = std::uncaught_exceptions();
+			return;
+		}
+
+		m_tempPath = filePath;
+		m_tempPath += ".tmp";
+
+		m_file = std::fstream(m_tempPath, std::ios::out | std::ios::binary);
 		if (!m_file.is_open())
-			throw(FileWriterException(std::format(L"Failed to open file {}", filePath.wstring())));
+			throw(FileWriterException(std::format(L"Failed to open file {}", m_tempPath.wstring())));
 		m_bufferMode = false;
+		m_exceptions = std::uncaught_exceptions();
 	}
 
-	~FileWriter()
+	// Failing to replace the target throws, unless the writer is destroyed during stack unwinding
+	~FileWriter() noexcept(false)
+	{
+		close();
+	}
+
+	using Sink = std::function<void(const std::filesystem::path&, std::vector<uint8_t>)>;
+
+	// While a sink is set files are not written to disk, instead the sink receives the path and content of every written file
+	static void SetSink(Sink sink)
 	{
-		if (m_file.is_open())
-			m_file.close();
+		s_sink = std::move(sink);
+	}
+
+	static bool HasSink()
+	{
+		return static_cast<bool>(s_sink);
+	}
+
+	// Passes a complete file to the sink, e.g., a file which is copied without being encoded
+	static void ToSink(const std::filesystem::path& filePath, std::vector<uint8_t> data)
+	{
+		s_sink(filePath, std::move(data));
 	}
 
 	uint8_t* Get()
@@ -568,10 +701,64 @@ private:
 			throw(FileWriterException("FileWriter not initialized"));
 	}
 
+private:
+	void close()
+	{
+		if (m_toSink)
+		{
+			m_toSink = false;
+
+			if (std::uncaught_exceptions() <= m_exceptions)
+				ToSink(m_filePath, std::move(m_buffer));
+
+			return;
+		}
+
+		if (!m_file.is_open()) return;
+
+		m_file.close();
+
+		const bool writeFailed = m_file.fail();
+
+		std::error_code ec;
+
+		// Keep the original file if the writer is destroyed during stack unwinding, i.e., the output is incomplete.
+		// Throwing is not possible in this case, so a failed cleanup is only reported.
+		if (std::uncaught_exceptions() > m_exceptions)
+		{
+			std::filesystem::remove(m_tempPath, ec);
+			if (ec)
+				std::cerr << std::format("Warning: Failed to remove temporary file {}: {}", m_tempPath.string(), ec.message()) << std::endl;
+
+			return;
+		}
+
+		if (!writeFailed)
+			std::filesystem::rename(m_tempPath, m_filePath, ec);
+
+		if (writeFailed || ec)
+		{
+			std::error_code removeEc;
+			std::filesystem::remove(m_tempPath, removeEc);
+
+			if (writeFailed)
+				throw(FileWriterException(std::format(L"Failed to write file {}", m_tempPath.wstring())));
+
+			throw(FileWriterException(std::format(L"Failed to replace file {}: {}", m_filePath.wstring(), fileAccessUtils::s2ws(ec.message()))));
+		}
+	}
+
 private:
 	bool m_bufferMode   = true;
 	uint64_t m_size     = 0;
 	std::fstream m_file = {};
+	int m_exceptions    = 0;
+	bool m_toSink       = false;
+
+	std::filesystem::path m_filePath = {};
+	std::filesystem::path m_tempPath = {};
+
+	inline static Sink s_sink = nullptr;
 
 	std::vector<uint8_t> m_buffer = {};
 };
\ No newline at end of file
@@ -26,7 +26,9 @@
 
 #pragma once
 
+#include "DecodeCache.hpp"
 #include "FileAccess.hpp"
+#include "StringPool.hpp"
 #include "Types.hpp"
 #include "WolfRPGException.hpp"
 #include "WolfRPGUtils.hpp"
@@ -124,7 +126,12 @@ public:
 		if (mode == Mode::READ)
 		{
 			m_reader.Open(filePath);
-			load();
+			m_fromFile = true;
+
+			if (DecodeCache::Enabled())
+				loadCached();
+			else
+				load();
 		}
 		else if (mode == Mode::WRITE)
 		{
@@ -138,7 +145,7 @@ public:
 		}
 	}
 
-	FileCoder(const Bytes& buffer, const Mode& mode, const WolfFileType& fileType, const SeedIncides& seedIndices = {}) :
+	FileCoder(Bytes buffer, const Mode& mode, const WolfFileType& fileType, const SeedIncides& seedIndices = {}) :
 		m_mode(mode),
 		m_seedIndices(seedIndices),
 		m_fileType(fileType)
@@ -149,7 +156,7 @@ public:
 		if (buffer.empty())
 			throw WolfRPGException(std::format("{}FileCoder: Buffer is empty", ERROR_TAG));
 
-		m_reader.InitData(buffer);
+		m_reader.InitData(std::move(buffer));
 		load();
 	}
 
@@ -161,6 +168,15 @@ public:
 			throw WolfRPGException(std::format("{}FileCoder: READ mode requires a filename or buffer.", ERROR_TAG));
 	}
 
+	// Reads a part of the already decoded data of another coder, e.g., to parse the parts of a file in parallel.
+	// The data is not copied, i.e., the other coder has to outlive this one.
+	FileCoder(const SourceSpan& span, const WolfFileType& fileType) :
+		m_mode(Mode::READ),
+		m_fileType(fileType)
+	{
+		m_reader.InitView(span.pData, span.size);
+	}
+
 	void Unpack(const bool& seekBack = false)
 	{
 		const uint32_t startOffset = m_reader.GetOffset();
@@ -181,7 +197,7 @@ public:
 		m_reader.Seek(0);
 		std::memcpy(decData.data(), m_reader.Get(), startOffset); // Copy header
 
-		m_reader.InitData(decData);
+		m_reader.InitData(std::move(decData));
 
 		if (seekBack)
 			m_reader.Seek(startOffset);
@@ -222,6 +238,13 @@ public:
 		return m_wasEncrypted;
 	}
 
+	// True if the data was read from a file, i.e., an unmodified object can copy the file instead of encoding it again.
+	// This is independent of how the data was decoded, the file on disk is already in its encrypted/compressed form.
+	bool IsFromFile() const
+	{
+		return m_fromFile;
+	}
+
 	void Seek(const int32_t& pos)
 	{
 		if (m_mode == Mode::READ)
@@ -239,6 +262,22 @@ public:
 		return m_reader.At(offset);
 	}
 
+	// Pointer to the current read position, stays valid after the coder is destroyed if the data was shared (see ShareSource)
+	const uint8_t* CurrentData() const
+	{
+		return m_reader.Get();
+	}
+
+	SourceSpan SpanFrom(const uint8_t* pStart) const
+	{
+		return { pStart, static_cast<uint32_t>(CurrentData() - pStart) };
+	}
+
+	std::shared_ptr<const void> ShareSource()
+	{
+		return m_reader.Share();
+	}
+
 	uint32_t GetOffset() const
 	{
 		if (m_mode == Mode::READ)
@@ -271,6 +310,13 @@ public:
 		return data;
 	}
 
+	// Read into an arena backed buffer, the buffer keeps its allocator
+	void Read(ArenaBytes& data, const std::size_t& size)
+	{
+		data.resize(size);
+		m_reader.ReadBytes(data.data(), size);
+	}
+
 	uint8_t ReadByte()
 	{
 		return m_reader.ReadUInt8();
@@ -288,15 +334,23 @@ public:
 		if (size == 0)
 			throw WolfRPGException(std::format("{}Zero length string encountered at offset {:#010x}.", ERROR_TAG, m_reader.GetOffset() - 4));
 
-		Bytes data = Read(size);
+		return decodeString(Read(size));
+	}
 
-		if (s_isUTF8)
-		{
-			std::string str = std::string(reinterpret_cast<const char*>(data.data()), data.size() - ((data.back() == 0x0) ? 1 : 0));
-			return ToUTF16(str);
-		}
-		else
-			return sjis2utf8(data);
+	// Same as ReadString, but strings which were already read before are taken from the string pool without decoding them again
+	PooledString ReadPooledString()
+	{
+		uint32_t size = ReadInt();
+
+		if (size == 0)
+			throw WolfRPGException(std::format("{}Zero length string encountered at offset {:#010x}.", ERROR_TAG, m_reader.GetOffset() - 4));
+
+		const uint8_t* pData = m_reader.Get();
+		m_reader.Skip(size);
+
+		const std::string_view encoded(reinterpret_cast<const char*>(pData), size);
+
+		return PooledString(StringPool::InternEncoded(encoded, s_isUTF8, [&]() { return decodeString(Bytes(pData, pData + size)); }));
 	}
 
 	Bytes ReadByteArray()
@@ -358,6 +412,12 @@ public:
 		s_isUTF8 = isUTF8;
 	}
 
+	// Skips a length prefixed string without decoding it
+	void SkipString()
+	{
+		Skip(ReadInt());
+	}
+
 	void Skip(const uint32_t& size)
 	{
 		m_reader.Skip(size);
@@ -368,6 +428,16 @@ public:
 		m_writer.WriteBytesVec(data);
 	}
 
+	void Write(const ArenaBytes& data)
+	{
+		m_writer.WriteBytes(data.data(), data.size());
+	}
+
+	void Write(const SourceSpan& span)
+	{
+		m_writer.WriteBytes(span.pData, static_cast<std::size_t>(span.size));
+	}
+
 	void Write(const MagicNumber& mn)
 	{
 		if (s_isUTF8)
@@ -433,7 +503,7 @@ public:
 	void WriteStringArray(const tStrings& strs)
 	{
 		WriteInt(static_cast<uint32_t>(strs.size()));
-		for (tString str : strs)
+		for (const tString& str : strs)
 			WriteString(str);
 	}
 
@@ -455,7 +525,47 @@ public:
 			return utf82sjis(str).size();
 	}
 
+	// Shift-JIS conversion independent of the encoding of the game, e.g., for file names inside of archives.
+	// The input has to be null terminated.
+	static tString DecodeSJIS(const Bytes& sjis)
+	{
+		return sjis2utf8(sjis);
+	}
+
+	// Copies an unmodified file to the output, i.e., to the file system or to the sink of FileWriter.
+	// Nothing is done if the output is the file itself (in place patching).
+	static void CopyToOutput(const std::filesystem::path& srcPath, const std::filesystem::path& dstPath)
+	{
+		if (FileWriter::HasSink())
+		{
+			FileReader reader(srcPath);
+			FileWriter::ToSink(dstPath, Bytes(reader.Get(), reader.Get() + reader.GetSize()));
+			return;
+		}
+
+		if (std::filesystem::exists(dstPath) && std::filesystem::equivalent(srcPath, dstPath)) return;
+
+		CopyFileFast(srcPath, dstPath);
+	}
+
+	// The result is null terminated
+	static Bytes EncodeSJIS(const tString& str)
+	{
+		return utf82sjis(str);
+	}
+
 private:
+	static tString decodeString(const Bytes& data)
+	{
+		if (s_isUTF8)
+		{
+			std::string str = std::string(reinterpret_cast<const char*>(data.data()), data.size() - ((data.back() == 0x0) ? 1 : 0));
+			return ToUTF16(str);
+		}
+		else
+			return sjis2utf8(data);
+	}
+
 	void cryptDatV1(Bytes& data, const SeedIncides& seeds)
 	{
 		wolf::crypt::datadecrypt::v2_0::decryptData(data, seeds);
@@ -594,7 +704,7 @@ private:
 		Bytes data = Read();
 		cryptDatV1(data, seeds);
 
-		m_reader.InitData(data);
+		m_reader.InitData(std::move(data));
 	}
 
 	void decryptV3_1()
@@ -655,11 +765,46 @@ private:
 		// wasEncrypted is not set here because the decryption function adds the required headers
 		s_isUTF8 = true;
 
-		m_reader.InitData(data);
+		m_reader.InitData(std::move(data));
 		// ¯\_(ツ)_/¯
 		s_projKey = 0;
 	}
 
+	// Use the decoded data of a previous run if the source did not change, otherwise decode and store it
+	void loadCached()
+	{
+		const uint64_t key = DecodeCache::Key(m_reader.Get(), m_reader.GetSize(), m_fileType, m_seedIndices, s_projKey);
+
+		if (const std::optional<DecodeCache::Trailer> trailer = DecodeCache::Open(m_reader, key))
+		{
+			m_wasEncrypted = trailer->wasEncrypted;
+			s_projKey      = trailer->projKey;
+			m_fromCache    = true;
+
+			if (trailer->isUTF8)
+				s_isUTF8 = true;
+
+			return;
+		}
+
+		const bool wasUTF8 = s_isUTF8;
+
+		load();
+
+		// Files which are used as is are already as fast to load as a cache entry
+		if (m_reader.IsMapped()) return;
+
+		DecodeCache::Trailer trailer;
+		trailer.offset       = m_reader.GetOffset();
+		trailer.projKey      = s_projKey;
+		trailer.wasEncrypted = m_wasEncrypted;
+		trailer.isUTF8       = (s_isUTF8 && !wasUTF8);
+
+		m_reader.Seek(0);
+		DecodeCache::Store(key, m_reader.Get(), m_reader.GetSize(), trailer);
+		m_reader.Seek(trailer.offset);
+	}
+
 	void load()
 	{
 		if (m_fileType == WolfFileType::Project)
@@ -668,7 +813,7 @@ private:
 			{
 				Bytes data = Read();
 				cryptProj(data);
-				m_reader.InitData(data);
+				m_reader.InitData(std::move(data));
 			}
 
 			return;
@@ -724,6 +869,8 @@ private:
 
 private:
 	bool m_wasEncrypted = false;
+	bool m_fromCache    = false;
+	bool m_fromFile     = false;
 	Mode m_mode;
 	SeedIncides m_seedIndices = {};
 	WolfFileType m_fileType;
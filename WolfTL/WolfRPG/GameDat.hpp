@@ -29,6 +29,7 @@
 // TODO: When integrating the decryption the filesize diff override might not be required anymore
 
 #include "FileCoder.hpp"
+#include "Schema.hpp"
 #include "WolfDataBase.hpp"
 #include "WolfRPGUtils.hpp"
 
@@ -51,6 +52,12 @@ public:
 		Load(buffer);
 	}
 
+	GameDat(const std::filesystem::path& filePath, Bytes buffer) :
+		WolfDataBase(filePath, MAGIC_NUMBER, WolfFileType::GameDat, false, SEED_INDICES)
+	{
+		Load(std::move(buffer));
+	}
+
 	const tString& GetTitle() const
 	{
 		return m_title;
@@ -59,6 +66,7 @@ public:
 	void SetTitle(const tString& title)
 	{
 		m_title = title;
+		markModified();
 	}
 
 	const tString& GetTitlePlus() const
@@ -69,6 +77,7 @@ public:
 	void SetTitlePlus(const tString& titlePlus)
 	{
 		m_titlePlus = titlePlus;
+		markModified();
 	}
 
 	const tString& GetFont() const
@@ -79,6 +88,7 @@ public:
 	void SetFont(const tString& font)
 	{
 		m_font = font;
+		markModified();
 	}
 
 	const tStrings& GetSubFonts() const
@@ -92,55 +102,36 @@ public:
 
 		// Ensure there are always 3 subfont entries, even if some of them are empty
 		m_subFonts.resize(3);
+		markModified();
 	}
 
-protected:
-	bool load(FileCoder& coder) override
+	// Entry of a sparse patch (see SparsePatch.hpp), addresses a string by its name in the JSON dump
+	bool PatchEntry(const nlohmann::ordered_json& j)
 	{
-		m_oldSize = coder.GetSize() - 1;
-
-		if (coder.GetOffset() == 0)
-			m_oldSize += static_cast<uint32_t>(FileCoder::CRYPT_HEADER_SIZE);
+		CHECK_JSON_KEY(j, "gameDat", "Game.dat");
+		CHECK_JSON_KEY(j, "value", "Game.dat");
 
-		m_unknown1    = coder.ReadByteArray();
-		m_stringCount = coder.ReadInt();
+		const std::string name = j["gameDat"].get<std::string>();
+		tString* pTarget       = JsonLayout::Find(name, j, *this);
 
-		// String 0
-		m_title = coder.ReadString();
+		if (pTarget == nullptr)
+			throw WolfRPGException(std::format("{}Unknown Game.dat entry in patch: {}", ERROR_TAG, name));
 
-		// String 1
-		m_magicString = coder.ReadString();
+		if (!UpdateValue(*pTarget, ToUTF16(j["value"].get<std::string>()))) return false;
 
-		if (m_magicString != MAGIC_STRING)
-			throw WolfRPGException(std::format(L"{}Invalid magic string: \"{}\" expected: \"{}\"", ERROR_TAGW, m_magicString, MAGIC_STRING));
-
-		// String 2
-		m_decryptKey = coder.ReadByteArray();
-		// String 3
-		m_font = coder.ReadString();
-
-		// Strings 4-6
-		for (uint32_t i = 0; i < 3; i++)
-			m_subFonts.push_back(coder.ReadString());
-
-		// String 7
-		m_defaultPCGraphic = coder.ReadString();
+		markModified();
+		return true;
+	}
 
-		// String 8
-		if (m_stringCount >= 9)
-			m_titlePlus = coder.ReadString();
+protected:
+	bool load(FileCoder& coder) override
+	{
+		m_oldSize = coder.GetSize() - 1;
 
-		// Strings 9-13
-		if (m_stringCount > 9)
-		{
-			m_roadImg    = coder.ReadString();
-			m_gaugeImg   = coder.ReadString();
-			m_startUpMsg = coder.ReadString();
-			m_titleMsg   = coder.ReadString();
-		}
+		if (coder.GetOffset() == 0)
+			m_oldSize += static_cast<uint32_t>(FileCoder::CRYPT_HEADER_SIZE);
 
-		if (m_stringCount > 13)
-			m_unknownString14 = coder.ReadString();
+		Layout::Read(coder, *this);
 
 		m_fileSize = coder.ReadInt();
 
@@ -162,27 +153,7 @@ protected:
 	{
 		coder.Write(MAGIC_NUMBER);
 
-		coder.WriteByteArray(m_unknown1);
-		coder.WriteInt(m_stringCount);
-		coder.WriteString(m_title);
-		coder.WriteString(MAGIC_STRING);
-		coder.WriteByteArray(m_decryptKey);
-		coder.WriteString(m_font);
-		for (const tString& font : m_subFonts)
-			coder.WriteString(font);
-		coder.WriteString(m_defaultPCGraphic);
-		if (m_stringCount >= 9) coder.WriteString(m_titlePlus);
-
-		if (m_stringCount > 9)
-		{
-			coder.WriteString(m_roadImg);
-			coder.WriteString(m_gaugeImg);
-			coder.WriteString(m_startUpMsg);
-			coder.WriteString(m_titleMsg);
-		}
-
-		if (m_stringCount > 13)
-			coder.WriteString(m_unknownString14);
+		Layout::Write(coder, *this);
 
 		// Based on the size of common game.dat files it can be expected that an uint32_t is sufficient to store the filesize
 		uint32_t newSize = calcNewSize();
@@ -202,42 +173,22 @@ protected:
 		coder.Write(m_unknown2);
 	}
 
-	nlohmann::ordered_json toJson() const
+	void writeJson(JsonWriter& writer) const
 	{
-		nlohmann::ordered_json j;
-
-		j["Title"]     = ToUTF8(m_title);
-		j["TitlePlus"] = ToUTF8(m_titlePlus);
+		JsonLayout::WriteJson(writer, *this);
+	}
 
-		if (m_stringCount > 9)
-		{
-			j["StartUpMsg"] = ToUTF8(m_startUpMsg);
-			j["TitleMsg"]   = ToUTF8(m_titleMsg);
-		}
+	bool patch(const nlohmann::ordered_json& j)
+	{
+		// A patch which matches the current state leaves the file untouched
+		JsonWriter current;
+		writeJson(current);
 
-		j["MainFont"] = ToUTF8(m_font);
-		j["SubFonts"] = nlohmann::ordered_json::array();
-		for (const tString& font : m_subFonts)
-			j["SubFonts"].push_back(ToUTF8(font));
+		if (j.dump(4) == current.GetString()) return false;
 
-		return j;
-	}
+		JsonLayout::Patch(j, *this);
 
-	void patch(const nlohmann::ordered_json& j)
-	{
-		m_title     = ToUTF16(j["Title"]);
-		m_titlePlus = ToUTF16(j["TitlePlus"]);
-
-		if (m_stringCount > 9)
-		{
-			m_startUpMsg = ToUTF16(j["StartUpMsg"]);
-			m_titleMsg   = ToUTF16(j["TitleMsg"]);
-		}
-
-		m_font = ToUTF16(j["MainFont"]);
-		m_subFonts.clear();
-		for (const auto& subFont : j["SubFonts"])
-			m_subFonts.push_back(ToUTF16(subFont));
+		return true;
 	}
 
 private:
@@ -245,31 +196,7 @@ private:
 	{
 		std::size_t size = 0;
 		size += MAGIC_NUMBER.Size();
-		size += m_unknown1.size() + 4;
-		size += sizeof(m_stringCount);
-		size += FileCoder::CalcStringSize(m_title) + 4;
-		size += FileCoder::CalcStringSize(MAGIC_STRING) + 4;
-		size += m_decryptKey.size() + 4;
-		size += FileCoder::CalcStringSize(m_font) + 4;
-
-		for (const tString& font : m_subFonts)
-			size += FileCoder::CalcStringSize(font) + 4;
-
-		size += FileCoder::CalcStringSize(m_defaultPCGraphic) + 4;
-
-		if (m_stringCount >= 9) size += FileCoder::CalcStringSize(m_titlePlus) + 4;
-
-		if (m_stringCount > 9)
-		{
-			size += FileCoder::CalcStringSize(m_roadImg) + 4;
-			size += FileCoder::CalcStringSize(m_gaugeImg) + 4;
-			size += FileCoder::CalcStringSize(m_startUpMsg) + 4;
-			size += FileCoder::CalcStringSize(m_titleMsg) + 4;
-		}
-
-		if (m_stringCount > 13)
-			size += FileCoder::CalcStringSize(m_unknownString14) + 4;
-
+		size += Layout::Size(*this);
 		size += sizeof(m_fileSize);
 
 		size += 4;                        // unknown size value
@@ -311,4 +238,31 @@ private:
 	inline static const SeedIncides SEED_INDICES = { 0, 8, 6 };
 	inline static const MagicNumber MAGIC_NUMBER{ { 0x57, 0x00, 0x00, 0x4f, 0x4c, 0x00, 0x46, 0x4d, 0x00 }, 8 };
 	inline static const tString MAGIC_STRING = L"0000-0000";
+
+	// Strings 0-13, the string count decides which of the optional strings are present
+	using Layout = schema::Record<
+		schema::ByteArray<&GameDat::m_unknown1>,
+		schema::Int<&GameDat::m_stringCount>,
+		schema::String<&GameDat::m_title>,
+		schema::Constant<&GameDat::m_magicString, MAGIC_STRING>,
+		schema::ByteArray<&GameDat::m_decryptKey>,
+		schema::String<&GameDat::m_font>,
+		schema::Strings<&GameDat::m_subFonts, 3>,
+		schema::String<&GameDat::m_defaultPCGraphic>,
+		schema::When<&GameDat::m_stringCount, 9, schema::String<&GameDat::m_titlePlus>>,
+		schema::When<&GameDat::m_stringCount, 10,
+					 schema::String<&GameDat::m_roadImg>,
+					 schema::String<&GameDat::m_gaugeImg>,
+					 schema::String<&GameDat::m_startUpMsg>,
+					 schema::String<&GameDat::m_titleMsg>>,
+		schema::When<&GameDat::m_stringCount, 14, schema::String<&GameDat::m_unknownString14>>>;
+
+	using JsonLayout = schema::JsonRecord<
+		schema::Text<"Title", &GameDat::m_title>,
+		schema::Text<"TitlePlus", &GameDat::m_titlePlus>,
+		schema::When<&GameDat::m_stringCount, 10,
+					 schema::Text<"StartUpMsg", &GameDat::m_startUpMsg>,
+					 schema::Text<"TitleMsg", &GameDat::m_titleMsg>>,
+		schema::Text<"MainFont", &GameDat::m_font>,
+		schema::TextList<"SubFonts", &GameDat::m_subFonts>>;
 };
\ No newline at end of file
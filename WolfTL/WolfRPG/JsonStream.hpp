@@ -0,0 +1,279 @@
+/*
+ *  File: JsonStream.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "Bundle.hpp"
+#include "FileAccess.hpp"
+#include "StringConv.hpp"
+#include "WolfRPGException.hpp"
+#include "WolfRPGUtils.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// Reads patch files with the SAX interface of nlohmann::json directly from the mapped file.
+// The elements of one top level array (e.g., the events of a map) can be handed to a callback as soon as they are parsed,
+// they are discarded afterwards, i.e., the memory usage is bound by the largest element instead of by the size of the file.
+// While a bundle is set the files are read from it instead of from the file system (see Bundle.hpp).
+class JsonStream
+{
+public:
+	using Json           = nlohmann::ordered_json;
+	using ElementHandler = std::function<void(const std::size_t& index, const Json& element)>;
+	using LineHandler    = std::function<void(const Json& line)>;
+
+	static void SetBundle(const Bundle* pBundle)
+	{
+		s_pBundle = pBundle;
+	}
+
+	static bool Exists(const std::filesystem::path& filePath)
+	{
+		if (s_pBundle)
+			return s_pBundle->Contains(filePath);
+
+		return std::filesystem::exists(filePath);
+	}
+
+	static Json Parse(const std::filesystem::path& filePath)
+	{
+		return Parse(filePath, "", nullptr);
+	}
+
+	// Returns the document without the elements of the array arrayKey, they are passed to the handler instead
+	static Json Parse(const std::filesystem::path& filePath, const std::string& arrayKey, ElementHandler handler)
+	{
+		Handler sax(filePath, arrayKey, std::move(handler));
+
+		if (s_pBundle)
+		{
+			const std::string_view data = s_pBundle->Get(filePath);
+			Json::sax_parse(data.data(), data.data() + data.size(), &sax);
+		}
+		else
+		{
+			FileReader reader(filePath);
+			const char* pBegin = reinterpret_cast<const char*>(reader.Get());
+			Json::sax_parse(pBegin, pBegin + reader.GetSize(), &sax);
+		}
+
+		return sax.TakeRoot();
+	}
+
+	// Reads a JSON Lines file, every non-empty line is parsed as a separate document and passed to the handler.
+	// Errors of the parser and the handler are reported with the line they occurred in.
+	static void ForEachLine(const std::filesystem::path& filePath, const LineHandler& handler)
+	{
+		FileReader reader(filePath);
+
+		const char* pLine = reinterpret_cast<const char*>(reader.Get());
+		const char* pEnd  = pLine + reader.GetSize();
+
+		std::size_t lineNo = 0;
+
+		while (pLine < pEnd)
+		{
+			const char* pEol = std::find(pLine, pEnd, '\n');
+			lineNo++;
+
+			if (std::any_of(pLine, pEol, [](const char& c) { return !std::isspace(static_cast<unsigned char>(c)); }))
+			{
+				try
+				{
+					handler(Json::parse(pLine, pEol));
+				}
+				catch (const std::exception& e)
+				{
+					throw WolfRPGException(std::format(L"{}Invalid entry in line {} of {}: {}", ERROR_TAGW, lineNo, filePath.wstring(), ToUTF16(e.what())));
+				}
+			}
+
+			pLine = (pEol == pEnd) ? pEnd : pEol + 1;
+		}
+	}
+
+private:
+
+	// Builds the DOM like the default parser, except for the elements of the streamed array
+	class Handler
+	{
+	public:
+		Handler(const std::filesystem::path& filePath, const std::string& arrayKey, ElementHandler handler) :
+			m_filePath(filePath),
+			m_arrayKey(arrayKey),
+			m_handler(std::move(handler))
+		{
+		}
+
+		Json TakeRoot()
+		{
+			return std::move(m_root);
+		}
+
+		bool null()
+		{
+			return value(nullptr);
+		}
+
+		bool boolean(bool val)
+		{
+			return value(val);
+		}
+
+		bool number_integer(Json::number_integer_t val)
+		{
+			return value(val);
+		}
+
+		bool number_unsigned(Json::number_unsigned_t val)
+		{
+			return value(val);
+		}
+
+		bool number_float(Json::number_float_t val, [[maybe_unused]] const Json::string_t& str)
+		{
+			return value(val);
+		}
+
+		bool string(Json::string_t& val)
+		{
+			return value(std::move(val));
+		}
+
+		bool binary(Json::binary_t& val)
+		{
+			return value(Json::binary(std::move(val)));
+		}
+
+		bool start_object([[maybe_unused]] std::size_t elements)
+		{
+			m_stack.push_back(add(Json::object()));
+			return true;
+		}
+
+		bool key(Json::string_t& val)
+		{
+			m_key = std::move(val);
+			return true;
+		}
+
+		bool end_object()
+		{
+			return end();
+		}
+
+		bool start_array([[maybe_unused]] std::size_t elements)
+		{
+			Json* pArray = add(Json::array());
+
+			if (m_handler && m_stack.size() == 1 && m_stack.back()->is_object() && m_key == m_arrayKey)
+				m_pStream = pArray;
+
+			m_stack.push_back(pArray);
+			return true;
+		}
+
+		bool end_array()
+		{
+			return end();
+		}
+
+		bool parse_error(std::size_t position, [[maybe_unused]] const std::string& lastToken, const nlohmann::detail::exception& ex)
+		{
+			throw WolfRPGException(std::format(L"{}Failed to parse {} at byte {}: {}", ERROR_TAGW, m_filePath.wstring(), position, ToUTF16(ex.what())));
+		}
+
+	private:
+		Json* add(Json&& val)
+		{
+			if (m_stack.empty())
+			{
+				m_root = std::move(val);
+				return &m_root;
+			}
+
+			Json& parent = *m_stack.back();
+			if (parent.is_array())
+			{
+				parent.push_back(std::move(val));
+				return &parent.back();
+			}
+
+			Json& member = parent[m_key];
+			member       = std::move(val);
+			return &member;
+		}
+
+		bool value(Json&& val)
+		{
+			add(std::move(val));
+			elementDone();
+			return true;
+		}
+
+		bool end()
+		{
+			// Members added to the root after the streamed array can relocate it
+			if (m_stack.back() == m_pStream)
+				m_pStream = nullptr;
+
+			m_stack.pop_back();
+			elementDone();
+			return true;
+		}
+
+		void elementDone()
+		{
+			if (m_pStream == nullptr || m_stack.empty() || m_stack.back() != m_pStream) return;
+
+			m_handler(m_count++, m_pStream->back());
+			m_pStream->clear();
+		}
+
+	private:
+		std::filesystem::path m_filePath;
+		std::string m_arrayKey;
+		ElementHandler m_handler;
+
+		Json m_root                = {};
+		std::vector<Json*> m_stack = {};
+		std::string m_key          = "";
+
+		Json* m_pStream     = nullptr;
+		std::size_t m_count = 0;
+	};
+
+	inline static const Bundle* s_pBundle = nullptr;
+};
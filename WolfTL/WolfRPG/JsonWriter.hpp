@@ -0,0 +1,270 @@
+/*
+ *  File: JsonWriter.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "FileAccess.hpp"
+#include "Types.hpp"
+#include "WolfRPGException.hpp"
+#include "WolfRPGUtils.hpp"
+
+#include <charconv>
+#include <concepts>
+#include <exception>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Streaming JSON serializer, the output is identical to nlohmann::ordered_json::dump(4) of the same structure.
+// The text is collected in a buffer which is flushed to the file whenever it grows beyond FLUSH_SIZE,
+// i.e., no DOM is built and the memory usage does not depend on the size of the output.
+// Without a file the complete text is kept in memory (see GetString).
+// While a FileWriter sink is set (e.g., for a dump bundle) the text is handed to the sink instead of being written to the file.
+class JsonWriter
+{
+public:
+	JsonWriter() = default;
+
+	explicit JsonWriter(const std::filesystem::path& filePath)
+	{
+		if (FileWriter::HasSink())
+		{
+			m_sinkPath   = filePath;
+			m_exceptions = std::uncaught_exceptions();
+			return;
+		}
+
+		m_file.open(filePath);
+		if (!m_file.is_open())
+			throw WolfRPGException(std::format(L"{}Failed to open file {}", ERROR_TAGW, filePath.wstring()));
+
+		m_buffer.reserve(FLUSH_SIZE + FLUSH_SIZE / 4);
+	}
+
+	~JsonWriter()
+	{
+		// Incomplete output of a failed serialization is not passed on
+		if (!m_sinkPath.empty() && std::uncaught_exceptions() == m_exceptions)
+			FileWriter::ToSink(m_sinkPath, Bytes(m_buffer.begin(), m_buffer.end()));
+
+		flush();
+	}
+
+	DISABLE_COPY_MOVE(JsonWriter)
+
+	void BeginObject()
+	{
+		open('{');
+	}
+
+	void EndObject()
+	{
+		close('}');
+	}
+
+	void BeginArray()
+	{
+		open('[');
+	}
+
+	void EndArray()
+	{
+		close(']');
+	}
+
+	// Starts a member of the current object, has to be followed by a value, an object or an array
+	void Key(const std::string_view& key)
+	{
+		newElement();
+		writeString(key);
+		m_buffer += ": ";
+		m_afterKey = true;
+	}
+
+	void Value(const std::string_view& str)
+	{
+		beginValue();
+		writeString(str);
+		valueDone();
+	}
+
+	template<std::integral T>
+	void Value(const T& value)
+	{
+		beginValue();
+
+		char buffer[24];
+		const std::to_chars_result res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+		m_buffer.append(buffer, res.ptr);
+
+		valueDone();
+	}
+
+	template<typename T>
+	void Value(const std::string_view& key, const T& value)
+	{
+		Key(key);
+		Value(value);
+	}
+
+	const std::string& GetString() const
+	{
+		return m_buffer;
+	}
+
+	// Serializes an object providing WriteJson(JsonWriter&) into a string
+	template<typename T>
+	static std::string ToString(const T& obj)
+	{
+		JsonWriter writer;
+		obj.WriteJson(writer);
+		return std::move(writer.m_buffer);
+	}
+
+private:
+	void beginValue()
+	{
+		if (m_afterKey)
+			m_afterKey = false;
+		else
+			newElement();
+	}
+
+	// Separator and indentation of a new element in the current container
+	void newElement()
+	{
+		if (m_counts.empty()) return;
+
+		if (m_counts.back()++ > 0)
+			m_buffer += ',';
+
+		m_buffer += '\n';
+		m_buffer.append(m_counts.size() * INDENT, ' ');
+	}
+
+	void open(const char& c)
+	{
+		beginValue();
+		m_buffer += c;
+		m_counts.push_back(0);
+	}
+
+	void close(const char& c)
+	{
+		const bool empty = (m_counts.back() == 0);
+		m_counts.pop_back();
+
+		// Empty containers are written as {} and []
+		if (!empty)
+		{
+			m_buffer += '\n';
+			m_buffer.append(m_counts.size() * INDENT, ' ');
+		}
+
+		m_buffer += c;
+		valueDone();
+	}
+
+	void valueDone()
+	{
+		if (m_file.is_open() && m_buffer.size() >= FLUSH_SIZE)
+			flush();
+	}
+
+	void flush()
+	{
+		if (!m_file.is_open()) return;
+
+		m_file.write(m_buffer.data(), m_buffer.size());
+		m_buffer.clear();
+	}
+
+	// Same escaping as nlohmann::json without ensure_ascii, i.e., only quotes, backslashes and control characters are escaped
+	void writeString(const std::string_view& str)
+	{
+		m_buffer += '"';
+
+		std::size_t start = 0;
+		for (std::size_t i = 0; i < str.size(); i++)
+		{
+			const uint8_t c = static_cast<uint8_t>(str[i]);
+			if (c > 0x1F && c != '"' && c != '\\') continue;
+
+			m_buffer.append(str.data() + start, i - start);
+			start = i + 1;
+
+			switch (c)
+			{
+				case '"':
+					m_buffer += "\\\"";
+					break;
+				case '\\':
+					m_buffer += "\\\\";
+					break;
+				case '\b':
+					m_buffer += "\\b";
+					break;
+				case '\f':
+					m_buffer += "\\f";
+					break;
+				case '\n':
+					m_buffer += "\\n";
+					break;
+				case '\r':
+					m_buffer += "\\r";
+					break;
+				case '\t':
+					m_buffer += "\\t";
+					break;
+				default:
+					m_buffer += std::format("\\u{:04x}", c);
+					break;
+			}
+		}
+
+		m_buffer.append(str.data() + start, str.size() - start);
+		m_buffer += '"';
+	}
+
+private:
+	static constexpr std::size_t INDENT     = 4;
+	static constexpr std::size_t FLUSH_SIZE = 1 << 20;
+
+	std::ofstream m_file = {};
+	std::string m_buffer = {};
+	bool m_afterKey      = false;
+
+	std::filesystem::path m_sinkPath = "";
+	int m_exceptions                 = 0;
+
+	// Number of elements written to each open container
+	std::vector<uint32_t> m_counts = {};
+};
@@ -0,0 +1,68 @@
+/*
+ *  File: LazyIndex.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+
+// Hash index from a key to the position of an element, built on the first lookup.
+// The owner resets the index whenever the indexed keys might have changed, the next lookup then rebuilds it.
+// If a key occurs multiple times its first position is kept, i.e., a lookup finds the same element as a linear search.
+// Lookups are not synchronized, concurrent lookups on the same object require external synchronization.
+template<typename Key>
+class LazyIndex
+{
+public:
+	// build is called with an insert function which has to be called with the key and position of every element
+	template<typename Builder>
+	std::optional<std::size_t> Find(const Key& key, Builder&& build) const
+	{
+		if (!m_built)
+		{
+			m_index.clear();
+			build([this](const Key& elemKey, const std::size_t& pos) { m_index.emplace(elemKey, pos); });
+			m_built = true;
+		}
+
+		const auto it = m_index.find(key);
+		if (it == m_index.end())
+			return std::nullopt;
+
+		return it->second;
+	}
+
+	void Reset()
+	{
+		m_index.clear();
+		m_built = false;
+	}
+
+private:
+	mutable std::unordered_map<Key, std::size_t> m_index = {};
+	mutable bool m_built                                = false;
+};
@@ -27,13 +27,16 @@
 #pragma once
 #include "Command.hpp"
 #include "FileCoder.hpp"
+#include "LazyIndex.hpp"
 #include "RouteCommand.hpp"
+#include "Schema.hpp"
 #include "WolfDataBase.hpp"
 #include "WolfRPGUtils.hpp"
 
 #include <fstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <optional>
 #include <vector>
 
 class Page
@@ -43,50 +46,34 @@ public:
 
 	bool Init(FileCoder& coder, uint32_t id)
 	{
-		m_id       = id;
-		m_unknown1 = coder.ReadInt();
+		m_id = id;
+		Head::Read(coder, *this);
 
-		m_graphicName       = coder.ReadString();
-		m_graphicDirection  = coder.ReadByte();
-		m_graphicFrame      = coder.ReadByte();
-		m_graphicOpacity    = coder.ReadByte();
-		m_graphicRenderMode = coder.ReadByte();
-
-		m_conditions = coder.Read(1 + 4 + 4 * 4 + 4 * 4);
-		m_movement   = coder.Read(4);
-
-		m_flags = coder.ReadByte();
-
-		m_routeFlags = coder.ReadByte();
+		const uint8_t* pRouteStart = coder.CurrentData();
 
 		uint32_t routeCount = coder.ReadInt();
+		m_route.reserve(routeCount);
 		for (uint32_t i = 0; i < routeCount; i++)
 		{
 			RouteCommand rc;
 			if (!rc.Init(coder))
 				throw WolfRPGException(std::format("{}RouteCommand initialization failed at index {}", ERROR_TAG, i));
 
-			m_route.push_back(rc);
+			m_route.push_back(std::move(rc));
 		}
 
+		// Routes can not be modified, so they are always copied from the source when dumping
+		m_routeSource = coder.SpanFrom(pRouteStart);
+
 		uint32_t commandCount = coder.ReadInt();
+		m_commands.Reserve(commandCount);
 		for (uint32_t i = 0; i < commandCount; i++)
 		{
-			Command::CommandShPtr::Command command = Command::Command::Init(coder);
-			if (!command->Valid())
+			if (!m_commands.Read(coder).Valid())
 				throw WolfRPGException(std::format("{}Command initialization failed at index {}", ERROR_TAG, i));
-
-			m_commands.push_back(command);
 		}
 
-		m_features = coder.ReadInt();
-
-		m_shadowGraphicNum = coder.ReadByte();
-		m_collisionWidth   = coder.ReadByte();
-		m_collisionHeight  = coder.ReadByte();
-
-		if (m_features > 3)
-			m_pageTransfer = coder.ReadByte();
+		Tail::Read(coder, *this);
 
 		uint8_t terminator = coder.ReadByte();
 		if (terminator != 0x7A)
@@ -95,56 +82,55 @@ public:
 		return true;
 	}
 
-	void Dump(FileCoder& coder) const
+	// Moves the coder behind the page without parsing it, has to follow the layout read by Init
+	static void Skip(FileCoder& coder)
 	{
-		coder.WriteInt(m_unknown1);
-		coder.WriteString(m_graphicName);
-		coder.WriteByte(m_graphicDirection);
-		coder.WriteByte(m_graphicFrame);
-		coder.WriteByte(m_graphicOpacity);
-		coder.WriteByte(m_graphicRenderMode);
-		coder.Write(m_conditions);
-		coder.Write(m_movement);
-		coder.WriteByte(m_flags);
-		coder.WriteByte(m_routeFlags);
-		coder.WriteInt(static_cast<uint32_t>(m_route.size()));
-		for (RouteCommand cmd : m_route)
-			cmd.Dump(coder);
-		coder.WriteInt(static_cast<uint32_t>(m_commands.size()));
-		for (const Command::CommandShPtr::Command& cmd : m_commands)
-			cmd->Dump(coder);
-		coder.WriteInt(m_features);
-		coder.WriteByte(m_shadowGraphicNum);
-		coder.WriteByte(m_collisionWidth);
-		coder.WriteByte(m_collisionHeight);
-
-		if (m_features > 3)
-			coder.WriteByte(m_pageTransfer);
+		coder.ReadInt();
+		coder.SkipString();
+		coder.Skip(4 + (1 + 4 + 4 * 4 + 4 * 4) + 4 + 2); // Graphic, conditions, movement and flags
 
-		coder.WriteByte(0x7A);
+		const uint32_t routeCount = coder.ReadInt();
+		for (uint32_t i = 0; i < routeCount; i++)
+			RouteCommand::Skip(coder);
+
+		Command::Commands::Skip(coder);
+
+		const uint32_t features = coder.ReadInt();
+		coder.Skip(features > 3 ? 4 : 3);
+
+		uint8_t terminator = coder.ReadByte();
+		if (terminator != 0x7A)
+			throw WolfRPGException(std::format("{}Page terminator not 0x7A (found: {:#02x})", ERROR_TAG, terminator));
 	}
 
-	nlohmann::ordered_json ToJson() const
+	void Dump(FileCoder& coder) const
 	{
-		nlohmann::ordered_json j;
-		j["id"]   = m_id;
-		j["list"] = nlohmann::ordered_json::array();
-
-		for (std::size_t i = 0; i < m_commands.size(); i++)
+		Head::Write(coder, *this);
+		if (m_routeSource.Valid())
+			coder.Write(m_routeSource);
+		else
 		{
-			nlohmann::ordered_json cmdJ = m_commands[i]->ToJson();
-
-			if (!cmdJ.empty())
-			{
-				cmdJ["index"] = i;
-				j["list"].push_back(cmdJ);
-			}
+			coder.WriteInt(static_cast<uint32_t>(m_route.size()));
+			for (const RouteCommand& cmd : m_route)
+				cmd.Dump(coder);
 		}
+		m_commands.Dump(coder);
+		Tail::Write(coder, *this);
+		coder.WriteByte(0x7A);
+	}
+
+	void WriteJson(JsonWriter& writer) const
+	{
+		writer.BeginObject();
+		writer.Value("id", m_id);
+
+		writer.Key("list");
+		m_commands.WriteJson(writer);
 
-		return j;
+		writer.EndObject();
 	}
 
-	void Patch(const nlohmann::ordered_json& j)
+	bool Patch(const nlohmann::ordered_json& j)
 	{
 		CHECK_JSON_KEY(j, "list", "pages");
 		CHECK_JSON_KEY(j, "id", "pages");
@@ -155,6 +141,7 @@ public:
 			throw WolfRPGException(std::format("{}Page ID mismatch in patch (expected {}, got {})", ERROR_TAG, m_id, id));
 
 		uint32_t cmdIdx = 0;
+		bool modified   = false;
 
 		for (const auto& cmdJ : j["list"])
 		{
@@ -165,8 +152,25 @@ public:
 			if (index >= m_commands.size())
 				throw WolfRPGException(std::format("{}Command index out of range in patch (index: {}, command count: {})", ERROR_TAG, index, m_commands.size()));
 
-			m_commands[index]->Patch(cmdJ);
+			modified |= m_commands.Patch(index, cmdJ);
 		}
+
+		return modified;
+	}
+
+	bool PatchEntry(const nlohmann::ordered_json& j)
+	{
+		return m_commands.PatchEntry(j);
+	}
+
+	void ExportTexts(TextTable& table, const std::string& prefix) const
+	{
+		m_commands.ExportTexts(table, prefix);
+	}
+
+	bool ApplyTexts(const TextTable& table, const std::string& prefix)
+	{
+		return m_commands.ApplyTexts(table, prefix);
 	}
 
 	const uint32_t& GetID() const
@@ -224,12 +228,12 @@ public:
 		m_graphicRenderMode = renderMode;
 	}
 
-	const Bytes& GetConditions() const
+	const ArenaBytes& GetConditions() const
 	{
 		return m_conditions;
 	}
 
-	const Bytes& GetMovement() const
+	const ArenaBytes& GetMovement() const
 	{
 		return m_movement;
 	}
@@ -287,26 +291,76 @@ public:
 private:
 	uint32_t m_id                = 0;
 	uint32_t m_unknown1          = 0;
-	tString m_graphicName        = TEXT("");
+	PooledString m_graphicName   = {};
 	uint8_t m_graphicDirection   = 0;
 	uint8_t m_graphicFrame       = 0;
 	uint8_t m_graphicOpacity     = 0;
 	uint8_t m_graphicRenderMode  = 0;
-	Bytes m_conditions           = {};
-	Bytes m_movement             = {};
+	ArenaBytes m_conditions      = ArenaBytes(Arena::Allocator());
+	ArenaBytes m_movement        = ArenaBytes(Arena::Allocator());
 	uint8_t m_flags              = 0;
 	uint8_t m_routeFlags         = 0;
-	RouteCommands m_route        = {};
+	RouteCommands m_route        = RouteCommands(Arena::Allocator());
+	SourceSpan m_routeSource     = {};
 	Command::Commands m_commands = {};
 	uint32_t m_features          = 0;
 	uint8_t m_shadowGraphicNum   = 0;
 	uint8_t m_collisionWidth     = 0;
 	uint8_t m_collisionHeight    = 0;
 	uint8_t m_pageTransfer       = 0;
+
+	// Fields in front of the route and behind the commands, the page transfer was added with feature level 4
+	using Head = schema::Record<
+		schema::Int<&Page::m_unknown1>,
+		schema::String<&Page::m_graphicName>,
+		schema::Byte<&Page::m_graphicDirection>,
+		schema::Byte<&Page::m_graphicFrame>,
+		schema::Byte<&Page::m_graphicOpacity>,
+		schema::Byte<&Page::m_graphicRenderMode>,
+		schema::Raw<&Page::m_conditions, 1 + 4 + 4 * 4 + 4 * 4>,
+		schema::Raw<&Page::m_movement, 4>,
+		schema::Byte<&Page::m_flags>,
+		schema::Byte<&Page::m_routeFlags>>;
+
+	using Tail = schema::Record<
+		schema::Int<&Page::m_features>,
+		schema::Byte<&Page::m_shadowGraphicNum>,
+		schema::Byte<&Page::m_collisionWidth>,
+		schema::Byte<&Page::m_collisionHeight>,
+		schema::When<&Page::m_features, 4, schema::Byte<&Page::m_pageTransfer>>>;
 };
 
 using Pages = std::vector<Page>;
 
+// Header of a map and of its events, read without parsing the tiles and the pages (see Map::Probe)
+struct MapInfo
+{
+	struct EventHeader
+	{
+		uint32_t id        = 0;
+		tString name       = TEXT("");
+		uint32_t x         = 0;
+		uint32_t y         = 0;
+		uint32_t pageCount = 0;
+
+		using Layout = schema::Record<
+			schema::Int<&EventHeader::id>,
+			schema::String<&EventHeader::name>,
+			schema::Int<&EventHeader::x>,
+			schema::Int<&EventHeader::y>,
+			schema::Int<&EventHeader::pageCount>>;
+	};
+
+	uint32_t version    = 0;
+	uint32_t tilesetID  = 0;
+	uint32_t width      = 0;
+	uint32_t height     = 0;
+	uint32_t eventCount = 0;
+	uint32_t layerCount = 3;
+
+	std::vector<EventHeader> events = {};
+};
+
 class Event
 {
 public:
@@ -316,14 +370,13 @@ public:
 	{
 		VERIFY_MAGIC(coder, MAGIC_NUMBER1);
 
-		m_id               = coder.ReadInt();
-		m_name             = coder.ReadString();
-		m_x                = coder.ReadInt();
-		m_y                = coder.ReadInt();
+		Layout::Read(coder, *this);
 		uint32_t pageCount = coder.ReadInt();
 
 		VERIFY_MAGIC(coder, MAGIC_NUMBER2);
 
+		m_pages.reserve(pageCount);
+
 		uint8_t indicator = 0x0;
 		uint32_t pageID   = 0;
 		while ((indicator = coder.ReadByte()) == 0x79)
@@ -332,7 +385,7 @@ public:
 			if (!page.Init(coder, pageID))
 				throw WolfRPGException(std::format("{}Page initialization failed at index {}", ERROR_TAG, pageID));
 
-			m_pages.push_back(page);
+			m_pages.push_back(std::move(page));
 			pageID++;
 		}
 
@@ -347,17 +400,49 @@ public:
 		return m_valid;
 	}
 
+	// Reads the header of the event and skips its pages
+	static MapInfo::EventHeader Probe(FileCoder& coder)
+	{
+		VERIFY_MAGIC(coder, MAGIC_NUMBER1);
+
+		MapInfo::EventHeader header;
+		MapInfo::EventHeader::Layout::Read(coder, header);
+
+		VERIFY_MAGIC(coder, MAGIC_NUMBER2);
+
+		uint8_t indicator = 0x0;
+		while ((indicator = coder.ReadByte()) == 0x79)
+			Page::Skip(coder);
+
+		if (indicator != 0x70)
+			throw WolfRPGException(std::format("{}Event terminator not 0x70 (found: {:#02x})", ERROR_TAG, indicator));
+
+		return header;
+	}
+
+	// Moves the coder behind the event without parsing it, has to follow the layout read by Init
+	static void Skip(FileCoder& coder)
+	{
+		coder.Skip(4 + 4); // Magic number and ID
+		coder.SkipString();
+		coder.Skip(4 + 4 + 4 + 4); // Position, page count and magic number
+
+		uint8_t indicator = 0x0;
+		while ((indicator = coder.ReadByte()) == 0x79)
+			Page::Skip(coder);
+
+		if (indicator != 0x70)
+			throw WolfRPGException(std::format("{}Event terminator not 0x70 (found: {:#02x})", ERROR_TAG, indicator));
+	}
+
 	void Dump(FileCoder& coder) const
 	{
 		coder.Write(MAGIC_NUMBER1);
-		coder.WriteInt(m_id);
-		coder.WriteString(m_name);
-		coder.WriteInt(m_x);
-		coder.WriteInt(m_y);
+		Layout::Write(coder, *this);
 		coder.WriteInt(static_cast<uint32_t>(m_pages.size()));
 		coder.Write(MAGIC_NUMBER2);
 
-		for (Page page : m_pages)
+		for (const Page& page : m_pages)
 		{
 			coder.WriteByte(0x79);
 			page.Dump(coder);
@@ -366,20 +451,22 @@ public:
 		coder.WriteByte(0x70);
 	}
 
-	nlohmann::ordered_json ToJson() const
+	void WriteJson(JsonWriter& writer) const
 	{
-		nlohmann::ordered_json j;
-		j["id"]    = m_id;
-		j["name"]  = ToUTF8(m_name);
-		j["pages"] = nlohmann::ordered_json::array();
+		writer.BeginObject();
+		writer.Value("id", m_id);
+		writer.Value("name", ToUTF8(m_name));
 
+		writer.Key("pages");
+		writer.BeginArray();
 		for (const Page& page : m_pages)
-			j["pages"].push_back(page.ToJson());
+			page.WriteJson(writer);
+		writer.EndArray();
 
-		return j;
+		writer.EndObject();
 	}
 
-	void Patch(const nlohmann::ordered_json& j)
+	bool Patch(const nlohmann::ordered_json& j)
 	{
 		CHECK_JSON_KEY(j, "pages", "events");
 		CHECK_JSON_KEY(j, "id", "events");
@@ -389,8 +476,40 @@ public:
 		if (id != m_id)
 			throw WolfRPGException(std::format("{}Event ID mismatch in patch (expected {}, got {})", ERROR_TAG, m_id, id));
 
+		bool modified = false;
+		for (std::size_t i = 0; i < m_pages.size(); i++)
+			modified |= m_pages[i].Patch(j["pages"][i]);
+
+		return modified;
+	}
+
+	// Entry of a sparse patch, addresses a command of a page
+	bool PatchEntry(const nlohmann::ordered_json& j)
+	{
+		CHECK_JSON_KEY(j, "page", "event");
+
+		const uint32_t page = j["page"].get<uint32_t>();
+		if (page >= m_pages.size())
+			throw WolfRPGException(std::format("{}Page index out of range in patch (page: {}, page count: {})", ERROR_TAG, page, m_pages.size()));
+
+		return m_pages[page].PatchEntry(j);
+	}
+
+	// The texts of a page are keyed by prefix/page index
+	void ExportTexts(TextTable& table, const std::string& prefix) const
+	{
 		for (std::size_t i = 0; i < m_pages.size(); i++)
-			m_pages[i].Patch(j["pages"][i]);
+			m_pages[i].ExportTexts(table, std::format("{}/{}", prefix, i));
+	}
+
+	bool ApplyTexts(const TextTable& table, const std::string& prefix)
+	{
+		bool modified = false;
+
+		for (std::size_t i = 0; i < m_pages.size(); i++)
+			modified |= m_pages[i].ApplyTexts(table, std::format("{}/{}", prefix, i));
+
+		return modified;
 	}
 
 	const uint32_t& GetID() const
@@ -446,8 +565,14 @@ private:
 	Pages m_pages  = {};
 	bool m_valid   = false;
 
-	const Bytes MAGIC_NUMBER1{ 0x39, 0x30, 0x00, 0x00 };
-	const Bytes MAGIC_NUMBER2{ 0x00, 0x00, 0x00, 0x00 };
+	inline static const Bytes MAGIC_NUMBER1{ 0x39, 0x30, 0x00, 0x00 };
+	inline static const Bytes MAGIC_NUMBER2{ 0x00, 0x00, 0x00, 0x00 };
+
+	using Layout = schema::Record<
+		schema::Int<&Event::m_id>,
+		schema::String<&Event::m_name>,
+		schema::Int<&Event::m_x>,
+		schema::Int<&Event::m_y>>;
 };
 
 using Events = std::vector<Event>;
@@ -462,11 +587,48 @@ public:
 			Load(filePath);
 	}
 
+	Map(const std::filesystem::path& filePath, Bytes buffer) :
+		WolfDataBase(filePath, MAGIC_NUMBER, WolfFileType::Map)
+	{
+		Load(std::move(buffer));
+	}
+
+	// Reads only the header of the map, i.e., the tiles are skipped and of the events only the headers are read.
+	// Without events the map is not read beyond its header.
+	static MapInfo Probe(const std::filesystem::path& filePath, const bool& withEvents = true)
+	{
+		g_activeFile = ::GetFileName(filePath);
+
+		// Reset the static variable for Command
+		Command::Command::s_v35 = false;
+
+		FileCoder coder(filePath, FileCoder::Mode::READ, WolfFileType::Map);
+		return probe(coder, withEvents);
+	}
+
+	static MapInfo Probe(const std::filesystem::path& filePath, Bytes buffer, const bool& withEvents = true)
+	{
+		g_activeFile = ::GetFileName(filePath);
+
+		// Reset the static variable for Command
+		Command::Command::s_v35 = false;
+
+		FileCoder coder(std::move(buffer), FileCoder::Mode::READ, WolfFileType::Map);
+		return probe(coder, withEvents);
+	}
+
 	const Events& GetEvents() const
 	{
 		return m_events;
 	}
 
+	// Returns nullptr if the map has no event with the given ID
+	const Event* FindEvent(const uint32_t& id) const
+	{
+		const std::optional<std::size_t> pos = findEventPos(id);
+		return pos ? &m_events[*pos] : nullptr;
+	}
+
 	const uint32_t& GetTilesetID() const
 	{
 		return m_tilesetID;
@@ -480,6 +642,7 @@ public:
 	void SetWidth(const uint32_t& width)
 	{
 		m_width = width;
+		markModified();
 	}
 
 	const uint32_t& GetHeight() const
@@ -490,6 +653,42 @@ public:
 	void SetHeight(const uint32_t& height)
 	{
 		m_height = height;
+		markModified();
+	}
+
+	// Entry of a sparse patch (see SparsePatch.hpp), addresses a command by event ID, page and command index
+	bool PatchEntry(const nlohmann::ordered_json& j)
+	{
+		CHECK_JSON_KEY(j, "event", "map");
+
+		if (!findEvent(j["event"].get<uint32_t>()).PatchEntry(j)) return false;
+
+		markModified();
+		return true;
+	}
+
+	// Adds the texts of the map to the table (see TextTable.hpp), the events are keyed by their ID
+	void ExportTexts(TextTable& table) const
+	{
+		const std::string prefix = textPrefix();
+
+		for (const Event& ev : m_events)
+			ev.ExportTexts(table, std::format("{}/{}", prefix, ev.GetID()));
+	}
+
+	// Returns true if the map was changed by the table
+	bool ApplyTexts(const TextTable& table)
+	{
+		const std::string prefix = textPrefix();
+		bool modified            = false;
+
+		for (Event& ev : m_events)
+			modified |= ev.ApplyTexts(table, std::format("{}/{}", prefix, ev.GetID()));
+
+		if (modified)
+			markModified();
+
+		return modified;
 	}
 
 protected:
@@ -533,16 +732,28 @@ protected:
 					coder.Seek(-4);
 			}
 
+			// Tiles can not be modified, so only their location in the source is kept and they are copied from it when dumping
 			if (readTiles)
-				m_tiles = coder.Read(m_width * m_height * m_layerCnt * 4);
-
-			while ((indicator = coder.ReadByte()) == EVENT_INDICATOR)
 			{
-				Event ev;
-				if (!ev.Init(coder))
-					throw WolfRPGException(std::format("{}Event initialization failed at index {}", ERROR_TAG, m_events.size()));
+				const uint8_t* pTilesStart = coder.CurrentData();
+				coder.Skip(m_width * m_height * m_layerCnt * 4);
+				m_tiles = coder.SpanFrom(pTilesStart);
+			}
+
+			m_events.reserve(eventCount);
 
-				m_events.push_back(ev);
+			if (eventCount >= PARALLEL_MIN_EVENTS)
+				indicator = loadEventsParallel(coder);
+			else
+			{
+				while ((indicator = coder.ReadByte()) == EVENT_INDICATOR)
+				{
+					Event ev;
+					if (!ev.Init(coder))
+						throw WolfRPGException(std::format("{}Event initialization failed at index {}", ERROR_TAG, m_events.size()));
+
+					m_events.push_back(std::move(ev));
+				}
 			}
 
 			if (m_events.size() != eventCount)
@@ -594,12 +805,12 @@ protected:
 			pCoder->WriteInt(m_layerCnt);
 		}
 
-		if (FileCoder::IsUTF8() && m_tiles.empty())
+		if (FileCoder::IsUTF8() && m_tiles.size == 0)
 			pCoder->WriteInt(0xFFFFFFFF);
 		else
 			pCoder->Write(m_tiles);
 
-		for (Event event : m_events)
+		for (const Event& event : m_events)
 		{
 			pCoder->WriteByte(EVENT_INDICATOR);
 			event.Dump(*pCoder);
@@ -614,21 +825,139 @@ protected:
 		}
 	}
 
-	nlohmann::ordered_json toJson() const
+	void writeJson(JsonWriter& writer) const
 	{
-		nlohmann::ordered_json j;
-		j["events"] = nlohmann::ordered_json::array();
+		writer.BeginObject();
 
+		writer.Key("events");
+		writer.BeginArray();
 		for (const Event& ev : m_events)
-			j["events"].push_back(ev.ToJson());
+			ev.WriteJson(writer);
+		writer.EndArray();
+
+		writer.EndObject();
+	}
+
+	// The events are patched one by one while the patch is parsed (see patchElement)
+	bool patch(const nlohmann::ordered_json& j)
+	{
+		CHECK_JSON_KEY(j, "events", "Map");
+		return false;
+	}
 
-		return j;
+	std::string streamedArray() const
+	{
+		return "events";
 	}
 
-	void patch(const nlohmann::ordered_json& j)
+	bool patchElement(const std::size_t& index, const nlohmann::ordered_json& j)
 	{
-		for (std::size_t i = 0; i < m_events.size(); i++)
-			m_events[i].Patch(j["events"][i]);
+		if (index >= m_events.size())
+			throw WolfRPGException(std::format("{}Event index out of range in patch (index {}, events count {})", ERROR_TAG, index, m_events.size()));
+
+		return m_events[index].Patch(j);
+	}
+
+private:
+	// Has to follow the layout read by load
+	static MapInfo probe(FileCoder& coder, const bool& withEvents)
+	{
+		if (!coder.WasEncrypted())
+			VERIFY_MAGIC(coder, MAGIC_NUMBER);
+
+		MapInfo info;
+		info.version = coder.ReadInt();
+		coder.ReadByte();
+		coder.SkipString();
+
+		info.tilesetID  = coder.ReadInt();
+		info.width      = coder.ReadInt();
+		info.height     = coder.ReadInt();
+		info.eventCount = coder.ReadInt();
+
+		if (info.version >= 0x67)
+		{
+			coder.ReadInt();
+			info.layerCount = coder.ReadInt();
+
+			Command::Command::s_v35 = true;
+		}
+
+		if (!withEvents || coder.GetOffset() == coder.GetSize() - 1)
+			return info;
+
+		bool hasTiles = true;
+
+		if (FileCoder::IsUTF8())
+		{
+			if (static_cast<int32_t>(coder.ReadInt()) == -1)
+				hasTiles = false;
+			else
+				coder.Seek(-4);
+		}
+
+		if (hasTiles)
+			coder.Skip(info.width * info.height * info.layerCount * 4);
+
+		info.events.reserve(info.eventCount);
+
+		while (coder.ReadByte() == EVENT_INDICATOR)
+			info.events.push_back(Event::Probe(coder));
+
+		return info;
+	}
+
+	// The first pass only determines the byte range of every event, the events are then parsed in parallel.
+	// Returns the indicator which ended the event list.
+	uint8_t loadEventsParallel(FileCoder& coder)
+	{
+		std::vector<SourceSpan> parts;
+
+		uint8_t indicator = 0x0;
+		while ((indicator = coder.ReadByte()) == EVENT_INDICATOR)
+		{
+			const uint8_t* pStart = coder.CurrentData();
+			Event::Skip(coder);
+			parts.push_back(coder.SpanFrom(pStart));
+		}
+
+		std::vector<std::optional<Event>> events(parts.size());
+
+		decodeParallel(parts, [&](FileCoder& partCoder, const std::size_t& index) {
+			if (!events[index].emplace().Init(partCoder))
+				throw WolfRPGException(std::format("{}Event initialization failed at index {}", ERROR_TAG, index));
+		});
+
+		for (std::optional<Event>& ev : events)
+			m_events.push_back(std::move(*ev));
+
+		return indicator;
+	}
+
+	std::string textPrefix() const
+	{
+		return "mps/" + ToUTF8(::GetFileNameNoExt(FileName()).wstring());
+	}
+
+	std::optional<std::size_t> findEventPos(const uint32_t& id) const
+	{
+		// The events are usually stored in the order of their IDs
+		if (id < m_events.size() && m_events[id].GetID() == id)
+			return id;
+
+		return m_eventIndex.Find(id, [this](const auto& insert) {
+			for (std::size_t i = 0; i < m_events.size(); i++)
+				insert(m_events[i].GetID(), i);
+		});
+	}
+
+	Event& findEvent(const uint32_t& id)
+	{
+		const std::optional<std::size_t> pos = findEventPos(id);
+		if (!pos)
+			throw WolfRPGException(std::format("{}Event with ID {} not found", ERROR_TAG, id));
+
+		return m_events[*pos];
 	}
 
 private:
@@ -641,14 +970,20 @@ private:
 	uint32_t m_tilesetID = 0;
 	uint32_t m_width     = 0;
 	uint32_t m_height    = 0;
-	Bytes m_tiles        = {};
+	SourceSpan m_tiles   = {};
 	Events m_events      = {};
 
+	// The IDs of the events never change, so the index is never reset
+	LazyIndex<uint32_t> m_eventIndex = {};
+
 	inline static const MagicNumber MAGIC_NUMBER{ { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 													0x57, 0x4F, 0x4C, 0x46, 0x4D, 0x00, 0x00, 0x00, 0x00, 0x00 },
 												  16 };
 	static constexpr uint8_t EVENT_INDICATOR = 0x6F;
 	static constexpr uint8_t TERMINATOR      = 0x66;
+
+	// Maps with fewer events are parsed sequentially, splitting them is not worth it
+	static constexpr uint32_t PARALLEL_MIN_EVENTS = 64;
 };
 
 using Maps = std::vector<Map>;
\ No newline at end of file
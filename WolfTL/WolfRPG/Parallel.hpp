@@ -0,0 +1,90 @@
+/*
+ *  File: Parallel.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Calls func(i) for every i in [0, count) using all available hardware threads.
+// Indices are handed out one at a time, i.e., uneven work per index is balanced automatically.
+// The first exception thrown by func is rethrown on the calling thread after all workers finished.
+template<typename Func>
+inline void ParallelFor(const std::size_t& count, Func&& func)
+{
+	const std::size_t threadCount = std::min<std::size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+
+	if (threadCount <= 1)
+	{
+		for (std::size_t i = 0; i < count; i++)
+			func(i);
+
+		return;
+	}
+
+	std::atomic<std::size_t> next = 0;
+	std::exception_ptr pError     = nullptr;
+	std::mutex errorMutex;
+
+	const auto worker = [&]() {
+		for (std::size_t i = next++; i < count; i = next++)
+		{
+			try
+			{
+				func(i);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(errorMutex);
+				if (!pError)
+					pError = std::current_exception();
+
+				// Stop handing out further work
+				next = count;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+
+	for (std::size_t t = 1; t < threadCount; t++)
+		threads.emplace_back(worker);
+
+	worker();
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	if (pError)
+		std::rethrow_exception(pError);
+}
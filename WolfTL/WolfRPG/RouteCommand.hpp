@@ -27,40 +27,57 @@
 #pragma once
 
 #include "FileCoder.hpp"
+#include "Schema.hpp"
+#include "SmallVector.hpp"
 #include "WolfRPGUtils.hpp"
 
 class RouteCommand
 {
 public:
+	using Args = SmallVector<uint32_t, 4>;
+
 	RouteCommand() = default;
 
 	bool Init(FileCoder& coder)
 	{
-		m_id              = coder.ReadByte();
-		uint32_t argCount = coder.ReadByte();
-
-		for (uint32_t i = 0; i < argCount; i++)
-			m_args.push_back(coder.ReadInt());
+		Layout::Read(coder, *this);
 
-		VERIFY_MAGIC(coder, TERMINATOR);
+		s_argSizes.Record(m_args.size());
 
 		return true;
 	}
 
+	// Moves the coder behind the next route command without parsing it
+	static void Skip(FileCoder& coder)
+	{
+		coder.ReadByte();
+		coder.Skip(coder.ReadByte() * 4);
+
+		VERIFY_MAGIC(coder, TERMINATOR);
+	}
+
 	void Dump(FileCoder& coder) const
 	{
-		coder.WriteByte(m_id);
-		coder.WriteByte((uint8_t)m_args.size());
-		for (uint32_t arg : m_args)
-			coder.WriteInt(arg);
-		coder.Write(TERMINATOR);
+		Layout::Write(coder, *this);
+	}
+
+	static const SizeHistogram& ArgSizes()
+	{
+		return s_argSizes;
 	}
 
 private:
 	uint8_t m_id = 0;
-	uInts m_args = {};
+	Args m_args  = {};
 
 	inline static const Bytes TERMINATOR{ 0x01, 0x00 };
+	inline static SizeHistogram s_argSizes = {};
+
+	// The argument count is stored as a single byte
+	using Layout = schema::Record<
+		schema::Byte<&RouteCommand::m_id>,
+		schema::IntArray<&RouteCommand::m_args, uint8_t>,
+		schema::Magic<TERMINATOR>>;
 };
 
-using RouteCommands = std::vector<RouteCommand>;
+using RouteCommands = std::pmr::vector<RouteCommand>;
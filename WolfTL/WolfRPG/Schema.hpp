@@ -0,0 +1,614 @@
+/*
+ *  File: Schema.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include "FileCoder.hpp"
+#include "JsonWriter.hpp"
+#include "StringPool.hpp"
+#include "WolfRPGException.hpp"
+#include "WolfRPGUtils.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <nlohmann/json.hpp>
+#include <type_traits>
+
+// Declarative layout of a record.
+// A record lists its fields once, e.g.,
+//   using Layout = schema::Record<schema::Int<&Foo::m_id>, schema::String<&Foo::m_name>>;
+// and reading, writing and the exact size of the written data are generated from this list at compile time.
+// Every field accesses the member in place, so neither loading nor dumping copies anything.
+// Fields which only exist in some versions of a format are grouped with schema::When or schema::WhenEqual,
+// their condition is a value of the record itself (e.g., a feature level or a string count), i.e., it is checked while reading.
+// The layouts do not depend on the v3.5 format or the encoding: the v3.5 additions are part of the commands and the map
+// header, which are read by hand, and strings are converted by the FileCoder.
+namespace schema
+{
+template<typename>
+struct MemberOf;
+
+template<typename C, typename M>
+struct MemberOf<M C::*>
+{
+	using Class = C;
+	using Type  = M;
+};
+
+template<auto Member>
+using MemberType = typename MemberOf<decltype(Member)>::Type;
+
+// String literal which can be passed as a template argument, used for the JSON keys
+template<std::size_t N>
+struct Name
+{
+	constexpr Name(const char (&str)[N])
+	{
+		std::copy_n(str, N, value);
+	}
+
+	constexpr std::string_view View() const
+	{
+		return std::string_view(value, N - 1);
+	}
+
+	char value[N] = {};
+};
+
+namespace detail
+{
+// Counts in front of lists are stored as a single byte or as an int
+template<typename Count>
+inline uint32_t ReadCount(FileCoder& coder)
+{
+	static_assert(std::is_same_v<Count, uint8_t> || std::is_same_v<Count, uint32_t>, "Unsupported count type");
+
+	if constexpr (std::is_same_v<Count, uint8_t>)
+		return coder.ReadByte();
+	else
+		return coder.ReadInt();
+}
+
+template<typename Count>
+inline void WriteCount(FileCoder& coder, const std::size_t& count)
+{
+	if constexpr (std::is_same_v<Count, uint8_t>)
+		coder.WriteByte(static_cast<uint8_t>(count));
+	else
+		coder.WriteInt(static_cast<uint32_t>(count));
+}
+} // namespace detail
+
+template<auto Member>
+struct Byte
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		obj.*Member = coder.ReadByte();
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		coder.WriteByte(obj.*Member);
+	}
+
+	template<typename T>
+	static constexpr std::size_t Size(const T&)
+	{
+		return 1;
+	}
+};
+
+template<auto Member>
+struct Int
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		obj.*Member = coder.ReadInt();
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		coder.WriteInt(obj.*Member);
+	}
+
+	template<typename T>
+	static constexpr std::size_t Size(const T&)
+	{
+		return 4;
+	}
+};
+
+// Length prefixed string, pooled strings are interned while reading
+template<auto Member>
+struct String
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		if constexpr (std::is_same_v<MemberType<Member>, PooledString>)
+			obj.*Member = coder.ReadPooledString();
+		else
+			obj.*Member = coder.ReadString();
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		coder.WriteString(obj.*Member);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T& obj)
+	{
+		return FileCoder::CalcStringSize(obj.*Member) + 4;
+	}
+};
+
+// Fixed number of strings without a count in front of them
+template<auto Member, uint32_t COUNT>
+struct Strings
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		(obj.*Member).clear();
+		(obj.*Member).reserve(COUNT);
+		for (uint32_t i = 0; i < COUNT; i++)
+			(obj.*Member).push_back(coder.ReadString());
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		for (const tString& str : obj.*Member)
+			coder.WriteString(str);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T& obj)
+	{
+		std::size_t size = 0;
+		for (const tString& str : obj.*Member)
+			size += FileCoder::CalcStringSize(str) + 4;
+
+		return size;
+	}
+};
+
+// Fixed number of raw bytes
+template<auto Member, uint32_t SIZE>
+struct Raw
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		if constexpr (std::is_same_v<MemberType<Member>, ArenaBytes>)
+			coder.Read(obj.*Member, SIZE);
+		else
+			obj.*Member = coder.Read(SIZE);
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		coder.Write(obj.*Member);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T& obj)
+	{
+		return (obj.*Member).size();
+	}
+};
+
+// Length prefixed byte array
+template<auto Member>
+struct ByteArray
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		obj.*Member = coder.ReadByteArray();
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		coder.WriteByteArray(obj.*Member);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T& obj)
+	{
+		return (obj.*Member).size() + 4;
+	}
+};
+
+// Count prefixed list of ints, Count is the type of the count (e.g., uint8_t for a single byte)
+template<auto Member, typename Count = uint32_t>
+struct IntArray
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		const uint32_t count = detail::ReadCount<Count>(coder);
+
+		(obj.*Member).clear();
+		(obj.*Member).reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+			(obj.*Member).push_back(coder.ReadInt());
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		detail::WriteCount<Count>(coder, (obj.*Member).size());
+		for (const uint32_t& value : obj.*Member)
+			coder.WriteInt(value);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T& obj)
+	{
+		return sizeof(Count) + (obj.*Member).size() * 4;
+	}
+};
+
+// Count prefixed list of strings
+template<auto Member, typename Count = uint32_t>
+struct StringArray
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		const uint32_t count = detail::ReadCount<Count>(coder);
+
+		(obj.*Member).clear();
+		(obj.*Member).reserve(count);
+		for (uint32_t i = 0; i < count; i++)
+			(obj.*Member).push_back(coder.ReadString());
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		detail::WriteCount<Count>(coder, (obj.*Member).size());
+		for (const tString& str : obj.*Member)
+			coder.WriteString(str);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T& obj)
+	{
+		std::size_t size = sizeof(Count);
+		for (const tString& str : obj.*Member)
+			size += FileCoder::CalcStringSize(str) + 4;
+
+		return size;
+	}
+};
+
+// Fixed bytes without a member, e.g., a terminator, which have to match VALUE
+template<const Bytes& VALUE>
+struct Magic
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T&)
+	{
+		VERIFY_MAGIC(coder, VALUE);
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T&)
+	{
+		coder.Write(VALUE);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T&)
+	{
+		return VALUE.size();
+	}
+};
+
+// Single indicator byte without a member which has to match VALUE, WHAT names it in the error message
+template<uint8_t VALUE, Name WHAT>
+struct Indicator
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T&)
+	{
+		const uint8_t indicator = coder.ReadByte();
+		if (indicator != VALUE)
+			throw WolfRPGException(std::format("{}{} indicator not {:#02x} (got {:#02x})", ERROR_TAG, WHAT.View(), VALUE, indicator));
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T&)
+	{
+		coder.WriteByte(VALUE);
+	}
+
+	template<typename T>
+	static constexpr std::size_t Size(const T&)
+	{
+		return 1;
+	}
+};
+
+// String which has to match VALUE, the expected value is written back
+template<auto Member, const tString& VALUE>
+struct Constant
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		obj.*Member = coder.ReadString();
+
+		if (obj.*Member != VALUE)
+			throw WolfRPGException(std::format(L"{}Invalid magic string: \"{}\" expected: \"{}\"", ERROR_TAGW, obj.*Member, VALUE));
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T&)
+	{
+		coder.WriteString(VALUE);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T&)
+	{
+		return FileCoder::CalcStringSize(VALUE) + 4;
+	}
+};
+
+namespace detail
+{
+template<auto Member, uint32_t MIN>
+struct AtLeast
+{
+	template<typename T>
+	static bool Check(const T& obj)
+	{
+		return static_cast<uint32_t>(obj.*Member) >= MIN;
+	}
+};
+
+template<auto Member, uint32_t VALUE>
+struct Equals
+{
+	template<typename T>
+	static bool Check(const T& obj)
+	{
+		return static_cast<uint32_t>(obj.*Member) == VALUE;
+	}
+};
+
+// Fields which are only present if Condition holds for the record
+template<typename Condition, typename... Fields>
+struct Conditional
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		if (Condition::Check(obj))
+			(Fields::Read(coder, obj), ...);
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		if (Condition::Check(obj))
+			(Fields::Write(coder, obj), ...);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T& obj)
+	{
+		return Condition::Check(obj) ? (Fields::Size(obj) + ... + 0) : 0;
+	}
+
+	template<typename T>
+	static void WriteJson(JsonWriter& writer, const T& obj)
+	{
+		if (Condition::Check(obj))
+			(Fields::WriteJson(writer, obj), ...);
+	}
+
+	template<typename T>
+	static void Patch(const nlohmann::ordered_json& j, T& obj)
+	{
+		if (Condition::Check(obj))
+			(Fields::Patch(j, obj), ...);
+	}
+
+	template<typename T>
+	static tString* Find(const std::string_view& key, const nlohmann::ordered_json& j, T& obj)
+	{
+		tString* pStr = nullptr;
+		if (Condition::Check(obj))
+			((pStr = Fields::Find(key, j, obj)) || ...);
+
+		return pStr;
+	}
+};
+} // namespace detail
+
+// Fields which are only present if the value of Member is at least MIN, e.g., the string count of Game.dat
+template<auto Member, uint32_t MIN, typename... Fields>
+struct When : detail::Conditional<detail::AtLeast<Member, MIN>, Fields...>
+{
+};
+
+// Fields which are only present if the value of Member is VALUE, e.g., a marker in front of an optional string
+template<auto Member, uint32_t VALUE, typename... Fields>
+struct WhenEqual : detail::Conditional<detail::Equals<Member, VALUE>, Fields...>
+{
+};
+
+template<typename... Fields>
+struct Record
+{
+	template<typename T>
+	static void Read(FileCoder& coder, T& obj)
+	{
+		(Fields::Read(coder, obj), ...);
+	}
+
+	template<typename T>
+	static void Write(FileCoder& coder, const T& obj)
+	{
+		(Fields::Write(coder, obj), ...);
+	}
+
+	template<typename T>
+	static std::size_t Size(const T& obj)
+	{
+		return (Fields::Size(obj) + ... + 0);
+	}
+};
+
+// Translatable string in the JSON dump
+template<Name KEY, auto Member>
+struct Text
+{
+	template<typename T>
+	static void WriteJson(JsonWriter& writer, const T& obj)
+	{
+		if constexpr (std::is_same_v<MemberType<Member>, PooledString>)
+			writer.Value(KEY.View(), (obj.*Member).UTF8());
+		else
+			writer.Value(KEY.View(), ToUTF8(obj.*Member));
+	}
+
+	template<typename T>
+	static void Patch(const nlohmann::ordered_json& j, T& obj)
+	{
+		obj.*Member = ToUTF16(j[KEY.value].template get<std::string>());
+	}
+
+	template<typename T>
+	static tString* Find(const std::string_view& key, const nlohmann::ordered_json&, T& obj)
+	{
+		// Pooled strings are immutable, i.e., they cannot be patched in place
+		if constexpr (std::is_same_v<MemberType<Member>, PooledString>)
+			return nullptr;
+		else
+			return (key == KEY.View()) ? &(obj.*Member) : nullptr;
+	}
+};
+
+// List of translatable strings in the JSON dump, sparse patches address an entry by "index"
+template<Name KEY, auto Member>
+struct TextList
+{
+	template<typename T>
+	static void WriteJson(JsonWriter& writer, const T& obj)
+	{
+		writer.Key(KEY.View());
+		writer.BeginArray();
+		for (const tString& str : obj.*Member)
+			writer.Value(ToUTF8(str));
+		writer.EndArray();
+	}
+
+	template<typename T>
+	static void Patch(const nlohmann::ordered_json& j, T& obj)
+	{
+		(obj.*Member).clear();
+		for (const auto& str : j[KEY.value])
+			(obj.*Member).push_back(ToUTF16(str.template get<std::string>()));
+	}
+
+	template<typename T>
+	static tString* Find(const std::string_view& key, const nlohmann::ordered_json& j, T& obj)
+	{
+		if (key != KEY.View()) return nullptr;
+
+		CHECK_JSON_KEY(j, "index", KEY.value);
+
+		const uint32_t index = j["index"].template get<uint32_t>();
+		if (index >= (obj.*Member).size())
+			throw WolfRPGException(std::format("{}Index of \"{}\" out of range in patch (index: {}, count: {})", ERROR_TAG, KEY.View(), index, (obj.*Member).size()));
+
+		return &(obj.*Member)[index];
+	}
+};
+
+// Like TextList, but an empty list is left out of the dump and patches do not have to contain it
+template<Name KEY, auto Member>
+struct OptionalTextList : TextList<KEY, Member>
+{
+	template<typename T>
+	static void WriteJson(JsonWriter& writer, const T& obj)
+	{
+		if (!(obj.*Member).empty())
+			TextList<KEY, Member>::WriteJson(writer, obj);
+	}
+
+	template<typename T>
+	static void Patch(const nlohmann::ordered_json& j, T& obj)
+	{
+		if (j.contains(KEY.value))
+			TextList<KEY, Member>::Patch(j, obj);
+	}
+};
+
+// JSON representation of a record, the fields are written in the order they are listed
+template<typename... Fields>
+struct JsonRecord
+{
+	template<typename T>
+	static void WriteJson(JsonWriter& writer, const T& obj)
+	{
+		writer.BeginObject();
+		(Fields::WriteJson(writer, obj), ...);
+		writer.EndObject();
+	}
+
+	template<typename T>
+	static void Patch(const nlohmann::ordered_json& j, T& obj)
+	{
+		(Fields::Patch(j, obj), ...);
+	}
+
+	// Returns the string addressed by key, or nullptr if the record has no such string
+	template<typename T>
+	static tString* Find(const std::string_view& key, const nlohmann::ordered_json& j, T& obj)
+	{
+		tString* pStr = nullptr;
+		((pStr = Fields::Find(key, j, obj)) || ...);
+
+		return pStr;
+	}
+};
+} // namespace schema
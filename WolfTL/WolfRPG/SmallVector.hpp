@@ -0,0 +1,385 @@
+/*
+ *  File: SmallVector.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include "Arena.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <format>
+#include <memory_resource>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// Vector with inline storage for the first N elements, only larger sizes allocate.
+// The overflow storage is taken from the arena which was active when the vector was created (see Arena.hpp).
+// Restricted to trivially copyable types, elements are moved around with memcpy.
+template<typename T, std::size_t N>
+class SmallVector
+{
+	static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "SmallVector requires a trivially copyable type");
+
+public:
+	using value_type     = T;
+	using size_type      = std::size_t;
+	using iterator       = T*;
+	using const_iterator = const T*;
+
+	static constexpr std::size_t INLINE_CAPACITY = N;
+
+	SmallVector() :
+		m_pResource(Arena::Current())
+	{
+	}
+
+	SmallVector(const SmallVector& other) :
+		m_pResource(Arena::Current())
+	{
+		assign(other.begin(), other.end());
+	}
+
+	SmallVector(SmallVector&& other) noexcept :
+		m_pResource(other.m_pResource)
+	{
+		if (other.IsInline())
+			copyFrom(other.data(), other.size());
+		else
+		{
+			m_pData    = other.m_pData;
+			m_size     = other.m_size;
+			m_capacity = other.m_capacity;
+			other.reset();
+		}
+	}
+
+	~SmallVector()
+	{
+		release();
+	}
+
+	SmallVector& operator=(const SmallVector& other)
+	{
+		if (this != &other)
+			assign(other.begin(), other.end());
+
+		return *this;
+	}
+
+	SmallVector& operator=(SmallVector&& other) noexcept
+	{
+		if (this == &other)
+			return *this;
+
+		// Heap storage can only be taken over if it was allocated from the same resource
+		if (other.IsInline() || other.m_pResource != m_pResource)
+		{
+			m_size = 0;
+			reserve(other.size());
+			copyFrom(other.data(), other.size());
+			return *this;
+		}
+
+		release();
+		m_pData    = other.m_pData;
+		m_size     = other.m_size;
+		m_capacity = other.m_capacity;
+		other.reset();
+
+		return *this;
+	}
+
+	template<typename It>
+	void assign(It first, It last)
+	{
+		m_size = 0;
+		reserve(static_cast<std::size_t>(std::distance(first, last)));
+
+		for (; first != last; ++first)
+			m_pData[m_size++] = *first;
+	}
+
+	void push_back(const T& value)
+	{
+		if (m_size == m_capacity)
+		{
+			// value might be an element of this vector
+			const T copy = value;
+			grow(m_size + 1);
+			m_pData[m_size++] = copy;
+		}
+		else
+			m_pData[m_size++] = value;
+	}
+
+	void pop_back()
+	{
+		m_size--;
+	}
+
+	void clear()
+	{
+		m_size = 0;
+	}
+
+	void reserve(const std::size_t& capacity)
+	{
+		if (capacity > m_capacity)
+			grow(capacity);
+	}
+
+	void resize(const std::size_t& size, const T& value = T())
+	{
+		reserve(size);
+
+		for (std::size_t i = m_size; i < size; i++)
+			m_pData[i] = value;
+
+		m_size = static_cast<uint32_t>(size);
+	}
+
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+	std::size_t capacity() const
+	{
+		return m_capacity;
+	}
+
+	bool empty() const
+	{
+		return (m_size == 0);
+	}
+
+	T* data()
+	{
+		return m_pData;
+	}
+
+	const T* data() const
+	{
+		return m_pData;
+	}
+
+	T& operator[](const std::size_t& index)
+	{
+		return m_pData[index];
+	}
+
+	const T& operator[](const std::size_t& index) const
+	{
+		return m_pData[index];
+	}
+
+	T& at(const std::size_t& index)
+	{
+		checkIndex(index);
+		return m_pData[index];
+	}
+
+	const T& at(const std::size_t& index) const
+	{
+		checkIndex(index);
+		return m_pData[index];
+	}
+
+	T& front()
+	{
+		return m_pData[0];
+	}
+
+	const T& front() const
+	{
+		return m_pData[0];
+	}
+
+	T& back()
+	{
+		return m_pData[m_size - 1];
+	}
+
+	const T& back() const
+	{
+		return m_pData[m_size - 1];
+	}
+
+	iterator begin()
+	{
+		return m_pData;
+	}
+
+	iterator end()
+	{
+		return m_pData + m_size;
+	}
+
+	const_iterator begin() const
+	{
+		return m_pData;
+	}
+
+	const_iterator end() const
+	{
+		return m_pData + m_size;
+	}
+
+	bool operator==(const SmallVector& other) const
+	{
+		return std::equal(begin(), end(), other.begin(), other.end());
+	}
+
+	bool operator!=(const SmallVector& other) const
+	{
+		return !(*this == other);
+	}
+
+	// True if the elements are stored in the object itself, i.e., no allocation took place
+	bool IsInline() const
+	{
+		return (m_pData == inlineData());
+	}
+
+private:
+	T* inlineData()
+	{
+		return reinterpret_cast<T*>(m_inline);
+	}
+
+	const T* inlineData() const
+	{
+		return reinterpret_cast<const T*>(m_inline);
+	}
+
+	void grow(const std::size_t& minCapacity)
+	{
+		const std::size_t capacity = std::max<std::size_t>(minCapacity, m_capacity * 2);
+		T* pData                   = static_cast<T*>(m_pResource->allocate(capacity * sizeof(T), alignof(T)));
+
+		if (m_size > 0)
+			std::memcpy(pData, m_pData, m_size * sizeof(T));
+
+		release();
+
+		m_pData    = pData;
+		m_capacity = static_cast<uint32_t>(capacity);
+	}
+
+	void copyFrom(const T* pData, const std::size_t& size)
+	{
+		if (size > 0)
+			std::memcpy(m_pData, pData, size * sizeof(T));
+
+		m_size = static_cast<uint32_t>(size);
+	}
+
+	void release()
+	{
+		if (!IsInline())
+			m_pResource->deallocate(m_pData, m_capacity * sizeof(T), alignof(T));
+	}
+
+	void reset()
+	{
+		m_pData    = inlineData();
+		m_size     = 0;
+		m_capacity = N;
+	}
+
+	void checkIndex(const std::size_t& index) const
+	{
+		if (index >= m_size)
+			throw std::out_of_range(std::format("SmallVector index {} out of range (size: {})", index, m_size));
+	}
+
+private:
+	T* m_pData                             = inlineData();
+	uint32_t m_size                        = 0;
+	uint32_t m_capacity                    = N;
+	std::pmr::memory_resource* m_pResource = nullptr;
+	alignas(T) std::byte m_inline[N * sizeof(T)];
+};
+
+// Histogram of container sizes, used to check how well the inline capacities fit the data of a game
+class SizeHistogram
+{
+public:
+	void Record(const std::size_t& size)
+	{
+		if (s_enabled)
+			m_counts[std::min(size, m_counts.size() - 1)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void Print(std::ostream& out, const std::string& title, const std::size_t& inlineCapacity) const
+	{
+		uint64_t total = 0;
+		for (const std::atomic<uint64_t>& count : m_counts)
+			total += count.load(std::memory_order_relaxed);
+
+		out << std::format("{} ({} total, inline capacity {})", title, total, inlineCapacity) << std::endl;
+
+		if (total == 0)
+			return;
+
+		uint64_t cumulative = 0;
+		uint64_t inlined    = 0;
+
+		for (std::size_t size = 0; size < m_counts.size(); size++)
+		{
+			const uint64_t count = m_counts[size].load(std::memory_order_relaxed);
+			if (count == 0) continue;
+
+			cumulative += count;
+			if (size <= inlineCapacity)
+				inlined += count;
+
+			out << std::format("  {:>3}: {:>10} {:>6.2f}% {:>7.2f}%", size, count, percent(count, total), percent(cumulative, total)) << std::endl;
+		}
+
+		out << std::format("  Stored inline: {:.2f}%", percent(inlined, total)) << std::endl;
+	}
+
+	static void Enable(const bool& enable)
+	{
+		s_enabled = enable;
+	}
+
+private:
+	static double percent(const uint64_t& value, const uint64_t& total)
+	{
+		return 100.0 * static_cast<double>(value) / static_cast<double>(total);
+	}
+
+private:
+	std::array<std::atomic<uint64_t>, 256> m_counts = {};
+
+	inline static bool s_enabled = false;
+};
@@ -0,0 +1,119 @@
+/*
+ *  File: SparsePatch.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "JsonStream.hpp"
+#include "StringConv.hpp"
+#include "Types.hpp"
+#include "WolfRPG.hpp"
+#include "WolfRPGException.hpp"
+#include "WolfRPGUtils.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+
+// Sparse patches are JSON Lines files which only contain the changed entries instead of a complete copy of the dump.
+// Every line addresses a single entry, which is applied directly without touching the rest of the game data:
+//   {"map": "Map001", "event": 3, "page": 0, "index": 12, "code": 101, "stringArgs": ["..."]}
+//   {"common": 5, "index": 2, "code": 101, "stringArgs": ["..."]}
+//   {"common": 5, "name": "...", "description": "..."}
+//   {"db": "DataBase", "type": 0, "row": 1, "field": 0, "value": "..."}
+//   {"db": "DataBase", "type": 0, "row": 1, "name": "..."}
+//   {"db": "DataBase", "type": 0, "field": 2, "name": "..."}
+//   {"db": "DataBase", "type": 0, "name": "...", "description": "..."}
+//   {"gameDat": "Title", "value": "..."}
+//   {"gameDat": "SubFonts", "index": 0, "value": "..."}
+// Maps and databases are addressed by their file name without extension, events and common events by their ID
+// and everything else by its index, i.e., the same values which are used in the JSON dump.
+// Command entries have to contain the code of the command, entries for a different command are rejected.
+class SparsePatch
+{
+public:
+	explicit SparsePatch(WolfRPG& wolf) :
+		m_wolf(wolf)
+	{
+		for (Map& map : wolf.GetMaps())
+			m_maps.emplace(::GetFileNameNoExt(map.FileName()).wstring(), &map);
+
+		for (Database& db : wolf.GetDatabases())
+			m_databases.emplace(::GetFileNameNoExt(db.FileName()).wstring(), &db);
+	}
+
+	// Returns the number of entries which changed the game data
+	std::size_t Apply(const std::filesystem::path& filePath)
+	{
+		std::size_t changed = 0;
+
+		JsonStream::ForEachLine(filePath, [&](const nlohmann::ordered_json& j) {
+			if (apply(j))
+				changed++;
+		});
+
+		return changed;
+	}
+
+private:
+	bool apply(const nlohmann::ordered_json& j)
+	{
+		if (j.contains("map"))
+			return find(m_maps, j["map"], "Map").PatchEntry(j);
+
+		if (j.contains("db"))
+			return find(m_databases, j["db"], "Database").PatchEntry(j);
+
+		if (j.contains("common"))
+			return m_wolf.GetCommonEvents().PatchEntry(j);
+
+		if (j.contains("gameDat"))
+			return m_wolf.GetGameDat().PatchEntry(j);
+
+		throw WolfRPGException(std::format("{}Entry does not address a map, database, common event or Game.dat", ERROR_TAG));
+	}
+
+	template<typename T>
+	static T& find(const std::unordered_map<tString, T*>& index, const nlohmann::ordered_json& name, const std::string& kind)
+	{
+		const std::string nameStr = name.get<std::string>();
+
+		auto it = index.find(ToUTF16(nameStr));
+		if (it == index.end())
+			throw WolfRPGException(std::format("{}{} not found: {}", ERROR_TAG, kind, nameStr));
+
+		return *it->second;
+	}
+
+private:
+	WolfRPG& m_wolf;
+
+	std::unordered_map<tString, Map*> m_maps           = {};
+	std::unordered_map<tString, Database*> m_databases = {};
+};
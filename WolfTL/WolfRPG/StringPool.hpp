@@ -0,0 +1,198 @@
+/*
+ *  File: StringPool.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include "StringConv.hpp"
+#include "Types.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Project wide pool of immutable strings, identical strings share a single entry.
+// Every entry also caches its UTF-8 representation, which is what the JSON export uses.
+// Entries are never removed, i.e., pointers to them stay valid for the lifetime of the program.
+// The pool is split into shards with their own lock, i.e., threads decoding different files rarely wait for each other.
+class StringPool
+{
+public:
+	using Entry = std::pair<const tString, std::string>;
+
+	static const Entry* Intern(const tString& str)
+	{
+		EntryShard& shard = s_entries[shardOf(std::hash<tString>{}(str))];
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+
+		auto it = shard.map.find(str);
+		if (it == shard.map.end())
+			it = shard.map.emplace(str, ToUTF8(str)).first;
+
+		return &(*it);
+	}
+
+	// Intern a string based on its raw (file encoded) bytes, the decoder is only called if the bytes were not seen before
+	template<typename Decoder>
+	static const Entry* InternEncoded(const std::string_view& encoded, const bool& isUTF8, Decoder&& decode)
+	{
+		EncodedShard& shard = s_encoded[isUTF8 ? 1 : 0][shardOf(EncodedHash{}(encoded))];
+
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+
+			// Heterogeneous lookup, the key is only allocated when a new string is inserted
+			auto it = shard.map.find(encoded);
+			if (it != shard.map.end())
+				return it->second;
+		}
+
+		// Decoded without holding a lock, if another thread inserts the same bytes meanwhile both get the same entry
+		const Entry* pEntry = Intern(decode());
+
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		shard.map.emplace(encoded, pEntry);
+
+		return pEntry;
+	}
+
+	static const Entry* Empty()
+	{
+		static const Entry* pEmpty = Intern(TEXT(""));
+		return pEmpty;
+	}
+
+	static std::size_t Size()
+	{
+		std::size_t size = 0;
+
+		for (EntryShard& shard : s_entries)
+		{
+			std::lock_guard<std::mutex> lock(shard.mutex);
+			size += shard.map.size();
+		}
+
+		return size;
+	}
+
+private:
+	// The upper bits of the scrambled hash select the shard, the containers use the lower bits for their buckets
+	static std::size_t shardOf(const std::size_t& hash)
+	{
+		return static_cast<std::size_t>((static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull) >> (64 - SHARD_BITS));
+	}
+
+private:
+	struct EncodedHash
+	{
+		using is_transparent = void;
+
+		std::size_t operator()(const std::string_view& str) const
+		{
+			return std::hash<std::string_view>{}(str);
+		}
+	};
+
+	using EncodedIndex = std::unordered_map<std::string, const Entry*, EncodedHash, std::equal_to<>>;
+
+	template<typename Map>
+	struct Shard
+	{
+		std::mutex mutex;
+		Map map;
+	};
+
+	// Node based containers, i.e., the address of an entry never changes
+	using EntryShard   = Shard<std::unordered_map<tString, std::string>>;
+	using EncodedShard = Shard<EncodedIndex>;
+
+	static constexpr uint32_t SHARD_BITS     = 6;
+	static constexpr std::size_t SHARD_COUNT = std::size_t(1) << SHARD_BITS;
+
+	inline static EntryShard s_entries[SHARD_COUNT];
+	inline static EncodedShard s_encoded[2][SHARD_COUNT];
+};
+
+// Lightweight handle to a pooled string, copying it only copies a pointer
+class PooledString
+{
+public:
+	PooledString() :
+		m_pEntry(StringPool::Empty())
+	{
+	}
+
+	PooledString(const tString& str) :
+		m_pEntry(StringPool::Intern(str))
+	{
+	}
+
+	explicit PooledString(const StringPool::Entry* pEntry) :
+		m_pEntry(pEntry)
+	{
+	}
+
+	static PooledString FromUTF8(const std::string& utf8)
+	{
+		return PooledString(ToUTF16(utf8));
+	}
+
+	const tString& Str() const
+	{
+		return m_pEntry->first;
+	}
+
+	const std::string& UTF8() const
+	{
+		return m_pEntry->second;
+	}
+
+	operator const tString&() const
+	{
+		return Str();
+	}
+
+	bool empty() const
+	{
+		return Str().empty();
+	}
+
+	// Pooled strings are unique, so comparing the entries is sufficient
+	bool operator==(const PooledString& other) const
+	{
+		return m_pEntry == other.m_pEntry;
+	}
+
+private:
+	const StringPool::Entry* m_pEntry;
+};
+
+using PooledStrings = std::pmr::vector<PooledString>;
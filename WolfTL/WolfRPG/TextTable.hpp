@@ -0,0 +1,200 @@
+/*
+ *  File: TextTable.hpp
+ *  Copyright (c) 2026 Sinflower
+ *
+ *  MIT License
+ *
+ *  Permission is hereby granted, free of charge, to any person obtaining a copy
+ *  of this software and associated documentation files (the "Software"), to deal
+ *  in the Software without restriction, including without limitation the rights
+ *  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *  copies of the Software, and to permit persons to whom the Software is
+ *  furnished to do so, subject to the following conditions:
+ *
+ *  The above copyright notice and this permission notice shall be included in all
+ *  copies or substantial portions of the Software.
+ *
+ *  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ *  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ *  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ *  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ *  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ *  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ *  SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "FileAccess.hpp"
+#include "JsonStream.hpp"
+#include "StringConv.hpp"
+#include "Types.hpp"
+#include "WolfRPGException.hpp"
+#include "WolfRPGUtils.hpp"
+
+#include <cstddef>
+#include <filesystem>
+#include <format>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Flat table of the translatable texts, stored as JSON Lines file with one entry per text:
+//   {"key": "mps/Map001/3/0/12/0", "text": "..."}
+//   {"key": "common/5/2/0", "text": "..."}
+//   {"key": "db/DataBase/0/1/3", "text": "..."}
+// Keys of command texts consist of the map (file name and event ID, page) or the common event ID followed by the
+// command index and the index of the string argument. Keys of database values consist of the database, type, row and field.
+// When applying a table every text of the game data is looked up by its key, i.e., the table can contain any subset of the texts.
+// A deduplicated table (translation memory) stores every distinct text once together with the keys of all its occurrences,
+// on patch the text is applied to each of them:
+//   {"keys": ["mps/Map001/3/0/12/0", "common/5/2/0"], "text": "..."}
+class TextTable
+{
+public:
+	TextTable() = default;
+
+	explicit TextTable(const std::filesystem::path& filePath)
+	{
+		read(filePath);
+	}
+
+	DISABLE_COPY_MOVE(TextTable)
+
+	// Empty texts are skipped, there is nothing to translate
+	void Add(std::string key, const tString& text)
+	{
+		if (text.empty()) return;
+
+		m_entries.push_back({ std::move(key), ToUTF8(text) });
+	}
+
+	// Returns the text of the key or nullptr if the table does not contain the key
+	const std::string* Find(const std::string& key) const
+	{
+		auto it = m_index.find(key);
+		if (it == m_index.end()) return nullptr;
+
+		it->second.used = true;
+		return &it->second.text;
+	}
+
+	// Returns the number of written entries
+	std::size_t Write(const std::filesystem::path& filePath, const bool& deduplicate = false) const
+	{
+		std::string out;
+		std::size_t count = m_entries.size();
+
+		if (deduplicate)
+			count = writeMemory(out);
+		else
+		{
+			for (const auto& [key, text] : m_entries)
+			{
+				const nlohmann::ordered_json j = { { "key", key }, { "text", text } };
+				out += j.dump();
+				out += '\n';
+			}
+		}
+
+		FileWriter writer(filePath);
+		writer.WriteBytes(out.data(), out.size());
+
+		return count;
+	}
+
+	std::size_t Size() const
+	{
+		return m_entries.size() + m_index.size();
+	}
+
+	// Throws if an entry of the table was not looked up, i.e., its key does not address a text of the game
+	void CheckUnused() const
+	{
+		std::size_t unused      = 0;
+		const std::string* pKey = nullptr;
+
+		for (const auto& [key, entry] : m_index)
+		{
+			if (entry.used) continue;
+
+			unused++;
+			pKey = &key;
+		}
+
+		if (unused > 0)
+			throw WolfRPGException(std::format("{}{} entries of the text table do not address a text of the game, e.g., \"{}\"", ERROR_TAG, unused, *pKey));
+	}
+
+private:
+	// One entry per distinct text in the order of the first occurrence
+	std::size_t writeMemory(std::string& out) const
+	{
+		std::unordered_map<std::string_view, std::size_t> textIndex;
+		std::vector<std::pair<const std::string*, std::vector<const std::string*>>> groups;
+
+		for (const auto& [key, text] : m_entries)
+		{
+			const auto [it, inserted] = textIndex.try_emplace(text, groups.size());
+			if (inserted)
+				groups.push_back({ &text, {} });
+
+			groups[it->second].second.push_back(&key);
+		}
+
+		for (const auto& [pText, keys] : groups)
+		{
+			nlohmann::ordered_json j = { { "keys", nlohmann::ordered_json::array() }, { "text", *pText } };
+			for (const std::string* pKey : keys)
+				j["keys"].push_back(*pKey);
+
+			out += j.dump();
+			out += '\n';
+		}
+
+		return groups.size();
+	}
+
+	void addEntry(const std::string& key, const std::string& text)
+	{
+		if (!m_index.emplace(key, Entry{ text }).second)
+			throw WolfRPGException(std::format("{}Duplicate key \"{}\"", ERROR_TAG, key));
+	}
+
+	void read(const std::filesystem::path& filePath)
+	{
+		JsonStream::ForEachLine(filePath, [&](const nlohmann::ordered_json& j) {
+			CHECK_JSON_KEY(j, "text", "text table");
+
+			const std::string text = j["text"].get<std::string>();
+
+			if (j.contains("keys"))
+			{
+				for (const auto& key : j["keys"])
+					addEntry(key.get<std::string>(), text);
+			}
+			else
+			{
+				CHECK_JSON_KEY(j, "key", "text table");
+				addEntry(j["key"].get<std::string>(), text);
+			}
+		});
+	}
+
+private:
+	struct Entry
+	{
+		std::string text;
+		mutable bool used = false;
+	};
+
+	// Filled when exporting
+	std::vector<std::pair<std::string, std::string>> m_entries = {};
+	// Filled when reading a table
+	std::unordered_map<std::string, Entry> m_index = {};
+};
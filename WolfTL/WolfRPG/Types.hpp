@@ -27,6 +27,7 @@
 #pragma once
 
 #include <filesystem>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -65,8 +66,29 @@ using tString  = std::wstring;
 using tStrings = std::vector<tString>;
 using Paths    = std::vector<std::filesystem::path>;
 
+// Containers which are allocated from the arena of the file they belong to (see Arena.hpp)
+using ArenaBytes = std::pmr::vector<uint8_t>;
+using ArenaUInts = std::pmr::vector<uint32_t>;
+
 using SeedIncides = std::array<uint8_t, 3>;
 
+// Range of bytes inside the decoded data of a loaded file
+struct SourceSpan
+{
+	const uint8_t* pData = nullptr;
+	uint32_t size        = 0;
+
+	bool Valid() const
+	{
+		return (pData != nullptr);
+	}
+
+	const uint8_t* End() const
+	{
+		return pData + size;
+	}
+};
+
 #define DISABLE_COPY_MOVE(T)             \
 	T(T const &)               = delete; \
 	void operator=(T const &t) = delete; \
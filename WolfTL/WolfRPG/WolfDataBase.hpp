@@ -26,11 +26,19 @@
 
 #pragma once
 
+#include <algorithm>
 #include <format>
 #include <fstream>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include <thread>
+#include <vector>
 
+#include "Arena.hpp"
 #include "FileCoder.hpp"
+#include "JsonStream.hpp"
+#include "JsonWriter.hpp"
+#include "Parallel.hpp"
 #include "Types.hpp"
 
 class WolfDataBase
@@ -47,6 +55,37 @@ public:
 
 	virtual ~WolfDataBase() = default;
 
+	// The arena is exchanged on move, i.e., the moved-from object keeps the arena its (old) objects were allocated from
+	WolfDataBase(WolfDataBase&& other) noexcept :
+		m_filePath(std::move(other.m_filePath)),
+		m_magic(std::move(other.m_magic)),
+		m_saveUncompressed(other.m_saveUncompressed),
+		m_fileType(other.m_fileType),
+		m_seedIndices(std::move(other.m_seedIndices)),
+		m_modified(other.m_modified),
+		m_fromFile(other.m_fromFile),
+		m_pSource(std::move(other.m_pSource)),
+		m_pArena(std::move(other.m_pArena)),
+		m_partArenas(std::move(other.m_partArenas))
+	{
+	}
+
+	WolfDataBase& operator=(WolfDataBase&& other) noexcept
+	{
+		m_filePath         = std::move(other.m_filePath);
+		m_magic            = std::move(other.m_magic);
+		m_saveUncompressed = other.m_saveUncompressed;
+		m_fileType         = other.m_fileType;
+		m_seedIndices      = std::move(other.m_seedIndices);
+		m_modified         = other.m_modified;
+		m_fromFile         = other.m_fromFile;
+		m_pSource.swap(other.m_pSource);
+		m_pArena.swap(other.m_pArena);
+		m_partArenas.swap(other.m_partArenas);
+
+		return *this;
+	}
+
 	bool Load(const std::filesystem::path& filePath)
 	{
 		m_filePath = filePath;
@@ -67,20 +106,27 @@ public:
 		if (m_saveUncompressed)
 			coder.DumpReader(getUncompressedPath());
 
-		return load(coder);
+		m_fromFile = coder.IsFromFile();
+
+		return loadInArena(coder);
 	}
 
-	bool Load(const Bytes& buffer)
+	bool Load(Bytes buffer)
 	{
 		if (buffer.empty())
 			throw WolfRPGException(std::format("{}Trying to load with empty buffer", ERROR_TAG));
 
-		FileCoder coder(buffer, FileCoder::Mode::READ, m_fileType, m_seedIndices);
+		g_activeFile = ::GetFileName(m_filePath);
+
+		// Reset the static variable for Command
+		Command::Command::s_v35 = false;
+
+		FileCoder coder(std::move(buffer), FileCoder::Mode::READ, m_fileType, m_seedIndices);
 
 		if (!coder.WasEncrypted())
 			VERIFY_MAGIC(coder, m_magic);
 
-		return load(coder);
+		return loadInArena(coder);
 	}
 
 	void Dump(const std::filesystem::path& outputPath, const std::filesystem::path& dataPath) const
@@ -97,8 +143,16 @@ public:
 		std::filesystem::path relativePath = std::filesystem::relative(std::filesystem::absolute(m_filePath).parent_path(), std::filesystem::absolute(dataPath));
 		std::filesystem::path fullOutPath  = outputPath / relativePath / fileName;
 
-		// Make sure the target folder exists
-		CheckAndCreateDir(fullOutPath.parent_path());
+		// Make sure the target folder exists, not required if the output is redirected (e.g., into an archive)
+		if (!FileWriter::HasSink())
+			CheckAndCreateDir(fullOutPath.parent_path());
+
+		// Unmodified files are copied from the source, when patching in place they are not touched at all
+		if (!m_modified && m_fromFile)
+		{
+			FileCoder::CopyToOutput(m_filePath, fullOutPath);
+			return;
+		}
 
 		FileCoder coder(fullOutPath.wstring(), FileCoder::Mode::WRITE, m_fileType, m_seedIndices);
 		dump(coder);
@@ -113,10 +167,8 @@ public:
 		std::filesystem::path outputFilePath = outputPath / fileName;
 		outputFilePath += ".json"; // Don't use replace_extension here in case the filename contains a dot
 
-		std::ofstream out(outputFilePath);
-		out << toJson().dump(4);
-
-		out.close();
+		JsonWriter writer(outputFilePath);
+		writeJson(writer);
 	}
 
 	virtual void Patch(const std::filesystem::path& patchPath)
@@ -128,15 +180,19 @@ public:
 		std::filesystem::path patchFilePath = patchPath / fileName;
 		patchFilePath += ".json"; // Don't use replace_extension here in case the filename contains a dot
 
-		if (!std::filesystem::exists(patchFilePath))
+		if (!JsonStream::Exists(patchFilePath))
 			throw WolfRPGException(std::format(L"{}Patch file not found: {}", ERROR_TAGW, patchFilePath.wstring()));
 
-		nlohmann::ordered_json j;
-		std::ifstream in(patchFilePath);
-		in >> j;
-		in.close();
+		bool modified = false;
+
+		const nlohmann::ordered_json j = JsonStream::Parse(patchFilePath, streamedArray(), [&](const std::size_t& index, const nlohmann::ordered_json& element) {
+			modified |= patchElement(index, element);
+		});
+
+		modified |= patch(j);
 
-		patch(j);
+		if (modified)
+			m_modified = true;
 	}
 
 	const std::filesystem::path& FileName() const
@@ -144,6 +200,12 @@ public:
 		return m_filePath;
 	}
 
+	// True if the object was changed since it was loaded
+	bool IsModified() const
+	{
+		return m_modified;
+	}
+
 	static void SetUncompressedPath(const std::filesystem::path& path)
 	{
 		s_uncompressedPath = path;
@@ -152,10 +214,83 @@ public:
 protected:
 	virtual bool load(FileCoder& coder)                 = 0;
 	virtual void dump(FileCoder& coder) const           = 0;
-	virtual nlohmann::ordered_json toJson() const       = 0;
-	virtual void patch(const nlohmann::ordered_json& j) = 0;
+	virtual void writeJson(JsonWriter& writer) const    = 0;
+	// Returns true if the patch changed the object
+	virtual bool patch(const nlohmann::ordered_json& j) = 0;
+
+	// Name of a top level array of the patch whose elements are passed to patchElement while the patch is parsed,
+	// these elements are not part of the JSON passed to patch
+	virtual std::string streamedArray() const
+	{
+		return "";
+	}
+
+	virtual bool patchElement([[maybe_unused]] const std::size_t& index, [[maybe_unused]] const nlohmann::ordered_json& j)
+	{
+		return false;
+	}
+
+	void markModified()
+	{
+		m_modified = true;
+	}
+
+	// Parses independent parts of the decoded data (e.g., the events of a map) in parallel, decode(coder, index) is called
+	// with a coder limited to parts[index]. The parts are split into contiguous chunks, every chunk is parsed with an arena
+	// of its own as the arenas are not thread safe.
+	template<typename Func>
+	void decodeParallel(const std::vector<SourceSpan>& parts, Func&& decode)
+	{
+		const std::size_t chunkCount = std::min<std::size_t>(parts.size(), std::max(1u, std::thread::hardware_concurrency()) * CHUNKS_PER_THREAD);
+		if (chunkCount == 0) return;
+
+		const std::size_t firstArena = m_partArenas.size();
+
+		for (std::size_t c = 0; c < chunkCount; c++)
+		{
+			std::size_t size = 0;
+			for (std::size_t i = chunkBegin(c, chunkCount, parts.size()); i < chunkBegin(c + 1, chunkCount, parts.size()); i++)
+				size += parts[i].size;
+
+			m_partArenas.push_back(Arena::Create(size));
+		}
+
+		ParallelFor(chunkCount, [&](const std::size_t& c) {
+			Arena::Scope scope(m_partArenas[firstArena + c].get());
+
+			for (std::size_t i = chunkBegin(c, chunkCount, parts.size()); i < chunkBegin(c + 1, chunkCount, parts.size()); i++)
+			{
+				FileCoder coder(parts[i], m_fileType);
+				decode(coder, i);
+
+				if (!coder.IsEof())
+					throw WolfRPGException(std::format("{}Part {} was not read completely ({} of {} bytes)", ERROR_TAG, i, coder.GetOffset(), parts[i].size));
+			}
+		});
+	}
 
 private:
+	static std::size_t chunkBegin(const std::size_t& chunk, const std::size_t& chunkCount, const std::size_t& count)
+	{
+		return chunk * count / chunkCount;
+	}
+
+	// Everything allocated while parsing the file is taken from the arena of this object
+	bool loadInArena(FileCoder& coder)
+	{
+		if (!m_pArena)
+			m_pArena = Arena::Create(coder.GetSize());
+
+		Arena::Scope scope(m_pArena.get());
+		if (!load(coder))
+			return false;
+
+		// Keep the decoded data alive, unmodified parts are copied from it when dumping
+		m_pSource = coder.ShareSource();
+
+		return true;
+	}
+
 	std::filesystem::path getUncompressedPath() const
 	{
 		if (!s_uncompressedPath.empty())
@@ -176,5 +311,17 @@ protected:
 	SeedIncides m_seedIndices = {};
 
 private:
+	bool m_modified = false;
+	bool m_fromFile = false;
+
+	// Base class members are destroyed last, i.e., the source data and the arena outlive the objects of the derived classes
+	std::shared_ptr<const void> m_pSource     = nullptr;
+	std::unique_ptr<Arena::Resource> m_pArena = nullptr;
+	// Arenas of the parts which were parsed in parallel (see decodeParallel)
+	std::vector<std::unique_ptr<Arena::Resource>> m_partArenas = {};
+
+	// More chunks than threads to balance parts of different sizes
+	static constexpr std::size_t CHUNKS_PER_THREAD = 4;
+
 	static inline std::filesystem::path s_uncompressedPath = "";
 };
\ No newline at end of file
@@ -26,17 +26,36 @@
 
 #pragma once
 
+#include "CommandIndex.hpp"
 #include "CommonEvents.hpp"
 #include "Database.hpp"
+#include "DxArchive.hpp"
 #include "GameDat.hpp"
 #include "Map.hpp"
 #include "Types.hpp"
 
 #include <filesystem>
+#include <limits>
+#include <map>
+#include <optional>
+#include <unordered_map>
 
 class WolfRPG
 {
 public:
+	// Location of a command which calls a common event
+	struct CallSite
+	{
+		static constexpr std::size_t COMMON_EVENT = std::numeric_limits<std::size_t>::max();
+
+		std::size_t map  = COMMON_EVENT; // Index of the map in GetMaps() or COMMON_EVENT if the caller is a common event
+		uint32_t event   = 0;            // ID of the calling event or common event
+		uint32_t page    = 0;            // Page of the calling event, always 0 for common events
+		uint32_t command = 0;            // Index of the calling command
+	};
+
+	using CallSites = std::vector<CallSite>;
+
 	explicit WolfRPG(const std::filesystem::path& dataPath, const bool& skipGD = false, const bool& saveUncompressed = false) :
 		m_dataPath(dataPath),
 		m_skipGD(skipGD),
@@ -45,11 +64,15 @@ public:
 		try
 		{
 			WolfDataBase::SetUncompressedPath("uncompressed");
+			loadArchives();
 			loadGameDat();
 			loadCommonEvents();
 			loadDatabases();
 			loadMaps();
 
+			// Everything was moved into the parsed objects
+			m_archiveFiles.clear();
+
 			m_valid = true;
 		}
 		catch (std::exception& e)
@@ -73,29 +96,53 @@ public:
 	{
 		checkValid();
 
-		std::filesystem::path basicDataDir = outputPath / "BasicData";
+		CheckAndCreateDir(outputPath / "BasicData");
+		save(outputPath);
+	}
 
-		CheckAndCreateDir(basicDataDir);
+	// Writes the game files into a DX archive instead of into a folder, the archive replaces the data folder (e.g., Data.wolf).
+	// If the game data was loaded from archives the remaining files of all of them (images, sounds, ...) are carried over,
+	// the content of split archives (e.g., BasicData.wolf) is stored in the folder it is named after.
+	void Save2Archive(const std::filesystem::path& archivePath) const
+	{
+		checkValid();
 
-		if (!m_skipGD)
+		DxArchiveWriter writer(archivePath);
+
+		for (const std::filesystem::path& sourceArchive : m_sourceArchives)
 		{
-			std::cout << "Writing Game.dat to file ... ";
-			m_gameDat.Dump(outputPath, m_dataPath);
-			std::cout << "Done" << std::endl;
+			const bool dataArchive = (archiveKey(sourceArchive.stem()) == L"data");
+
+			// The split archives would remain next to the new archive
+			std::error_code ec;
+			if (!dataArchive && std::filesystem::equivalent(sourceArchive.parent_path(), archivePath.parent_path(), ec))
+				throw WolfRPGException(std::format(L"{}Cannot replace the split archives of the game in place, {} would remain next to {}", ERROR_TAGW, sourceArchive.filename().wstring(), archivePath.filename().wstring()));
+
+			writer.AddArchive(sourceArchive, dataArchive ? TEXT("") : sourceArchive.stem().wstring() + TEXT("/"));
 		}
 
-		std::cout << "Writing CommonEvents to file ... ";
-		m_commonEvents.Dump(outputPath, m_dataPath);
-		std::cout << "Done" << std::endl;
+		// The archive is based at the folder it is placed in, i.e., the written files are stored relative to it
+		const std::filesystem::path basePath = archivePath.parent_path();
 
-		std::cout << "Writing Databases to file ... ";
-		for (const Database& db : m_databases)
-			db.Dump(basicDataDir);
-		std::cout << "Done" << std::endl;
+		FileWriter::SetSink([&](const std::filesystem::path& filePath, Bytes data) {
+			writer.Add(filePath.lexically_relative(basePath).generic_wstring(), std::move(data));
+		});
 
-		std::cout << "Writing Maps to file ... ";
-		for (const Map& map : m_maps)
-			map.Dump(outputPath, m_dataPath);
+		try
+		{
+			save(basePath);
+		}
+		catch (...)
+		{
+			FileWriter::SetSink(nullptr);
+			throw;
+		}
+
+		FileWriter::SetSink(nullptr);
+
+		std::cout << "Writing " << archivePath.filename().string() << " ... " << std::flush;
+		CreateBackup(archivePath);
+		writer.Finish();
 		std::cout << "Done" << std::endl;
 	}
 
@@ -114,6 +161,7 @@ public:
 	Maps& GetMaps()
 	{
 		checkValid();
+		InvalidateIndexes();
 		return m_maps;
 	}
 
@@ -126,6 +174,7 @@ public:
 	CommonEvents& GetCommonEvents()
 	{
 		checkValid();
+		InvalidateIndexes();
 		return m_commonEvents;
 	}
 
@@ -147,6 +196,48 @@ public:
 		return m_databases;
 	}
 
+	// All commands which call the common event with the given ID, either by its ID or by its name.
+	// The index is built on the first call, handing out the maps or common events for modification discards it.
+	const CallSites& GetCommonEventCallers(const uint32_t& id) const
+	{
+		checkValid();
+
+		if (!m_callers)
+			indexCallers();
+
+		const auto it = m_callers->find(id);
+		if (it == m_callers->end())
+			return NO_CALLERS;
+
+		return it->second;
+	}
+
+	// Index of all commands, built on the first call, handing out the maps or common events for modification discards it
+	// and it is rebuilt on the next call
+	const CommandIndex& GetCommandIndex() const
+	{
+		checkValid();
+
+		if (!m_commandIndex)
+			m_commandIndex.emplace(m_maps, m_commonEvents);
+
+		return *m_commandIndex;
+	}
+
+	// The command at a position of the command index
+	const Command::Command& GetIndexedCommand(const std::size_t& pos) const
+	{
+		return GetCommandIndex().Get(pos, m_maps, m_commonEvents);
+	}
+
+	// Has to be called when the commands are modified through references obtained before the last index lookup,
+	// the indexes are rebuilt on their next use
+	void InvalidateIndexes()
+	{
+		m_callers.reset();
+		m_commandIndex.reset();
+	}
+
 private:
 	void checkValid() const
 	{
@@ -154,13 +245,153 @@ private:
 			throw WolfRPGException(std::format(L"{}Invalid WolfRPG object", ERROR_TAGW));
 	}
 
+	void indexCallers() const
+	{
+		m_callers.emplace();
+
+		for (std::size_t i = 0; i < m_maps.size(); i++)
+		{
+			for (const Event& ev : m_maps[i].GetEvents())
+			{
+				for (const Page& page : ev.GetPages())
+					indexCallers(page.GetCommands(), { i, ev.GetID(), page.GetID(), 0 });
+			}
+		}
+
+		for (const CommonEvent& ev : m_commonEvents.GetEvents())
+			indexCallers(ev.GetCommands(), { CallSite::COMMON_EVENT, ev.GetID(), 0, 0 });
+	}
+
+	void indexCallers(const Command::Commands& commands, CallSite site) const
+	{
+		commands.ForEach([&](const Command::Command& cmd) {
+			const std::optional<uint32_t> id = calledCommonEvent(cmd);
+			if (id)
+				(*m_callers)[*id].push_back(site);
+
+			site.command++;
+		});
+	}
+
+	std::optional<uint32_t> calledCommonEvent(const Command::Command& cmd) const
+	{
+		if (cmd.GetType() == Command::CommandType::CommonEvent)
+		{
+			// Common events are addressed by their ID plus an offset, smaller values address events of the current map
+			const Command::IntArgs& args = cmd.GetIntArgs();
+			if (!args.empty() && args[0] >= COMMON_EVENT_OFFSET && args[0] < COMMON_EVENT_OFFSET + COMMON_EVENT_RANGE)
+				return args[0] - COMMON_EVENT_OFFSET;
+		}
+		else if (cmd.GetType() == Command::CommandType::CommonEventByName)
+		{
+			const Command::StringArgs& texts = cmd.Texts();
+			if (texts.empty()) return std::nullopt;
+
+			if (const CommonEvent* pEvent = m_commonEvents.FindEventByName(texts[0]))
+				return pEvent->GetID();
+		}
+
+		return std::nullopt;
+	}
+
+	// Writes all game files, the output folders have to exist unless the output goes to a FileWriter sink
+	void save(const std::filesystem::path& outputPath) const
+	{
+		if (!m_skipGD)
+		{
+			std::cout << "Writing Game.dat to file ... ";
+			m_gameDat.Dump(outputPath, m_dataPath);
+			std::cout << "Done" << std::endl;
+		}
+
+		std::cout << "Writing CommonEvents to file ... ";
+		m_commonEvents.Dump(outputPath, m_dataPath);
+		std::cout << "Done" << std::endl;
+
+		std::cout << "Writing Databases to file ... ";
+		for (const Database& db : m_databases)
+			db.Dump(outputPath / "BasicData");
+		std::cout << "Done" << std::endl;
+
+		std::cout << "Writing Maps to file ... ";
+		for (const Map& map : m_maps)
+			map.Dump(outputPath, m_dataPath);
+		std::cout << "Done" << std::endl;
+	}
+
+	// Games can ship their data folders as DX archives (.wolf files) instead of as plain folders.
+	// In that case the game files are extracted into memory, the files keep the path they would have after extracting the archives.
+	void loadArchives()
+	{
+		if (std::filesystem::exists(m_dataPath / "BasicData")) return;
+
+		DxArchive::DeriveKey(m_dataPath);
+
+		for (const std::filesystem::directory_entry& p : std::filesystem::directory_iterator(m_dataPath))
+		{
+			const std::filesystem::path& archivePath = p.path();
+			if (archiveKey(archivePath.extension()) != L".wolf") continue;
+
+			std::cout << "Extracting " << archivePath.filename().string() << " ... " << std::flush;
+
+			DxArchive archive(archivePath);
+			m_sourceArchives.push_back(archivePath);
+
+			// Data.wolf contains the data folders, every other archive contains the content of the folder it is named after
+			const std::filesystem::path basePath = (archiveKey(archivePath.stem()) == L"data") ? m_dataPath : m_dataPath / archivePath.stem();
+
+			std::vector<const DxArchive::Entry*> entries;
+			for (const DxArchive::Entry& entry : archive.GetEntries())
+			{
+				const tString ext = archiveKey(std::filesystem::path(entry.path).extension());
+				if (ext == L".dat" || ext == L".project" || ext == L".mps")
+					entries.push_back(&entry);
+			}
+
+			std::vector<Bytes> data = archive.Extract(entries);
+
+			for (std::size_t i = 0; i < entries.size(); i++)
+			{
+				const std::filesystem::path filePath = basePath / entries[i]->path;
+				m_archiveFiles.emplace(archiveKey(filePath), ArchiveFile{ filePath, std::move(data[i]) });
+			}
+
+			std::cout << "Done" << std::endl;
+		}
+	}
+
+	// Archive file names are case insensitive
+	static tString archiveKey(const std::filesystem::path& path)
+	{
+		tString key = path.generic_wstring();
+		std::transform(key.begin(), key.end(), key.begin(), [](const wchar_t& c) { return static_cast<wchar_t>(std::towlower(c)); });
+		return key;
+	}
+
+	bool fromArchive() const
+	{
+		return !m_archiveFiles.empty();
+	}
+
+	Bytes takeArchiveFile(const std::filesystem::path& filePath)
+	{
+		auto it = m_archiveFiles.find(archiveKey(filePath));
+		if (it == m_archiveFiles.end())
+			throw WolfRPGException(std::format(L"{}File not found in the archives: {}", ERROR_TAGW, filePath.wstring()));
+
+		return std::move(it->second.data);
+	}
+
 	void loadGameDat()
 	{
 		if (m_skipGD) return;
 
 		std::cout << "Loading Game.dat ... " << std::flush;
 
-		m_gameDat = GameDat(m_dataPath / "BasicData/Game.dat", m_saveUncompressed);
+		if (fromArchive())
+			m_gameDat = GameDat(m_dataPath / "BasicData/Game.dat", takeArchiveFile(m_dataPath / "BasicData/Game.dat"));
+		else
+			m_gameDat = GameDat(m_dataPath / "BasicData/Game.dat", m_saveUncompressed);
 
 		std::cout << "Done" << std::endl;
 	}
@@ -169,8 +400,15 @@ private:
 	{
 		std::cout << "Loading Maps ... " << std::flush;
 
+		if (fromArchive())
+		{
+			loadArchiveMaps();
+			std::cout << "Done" << std::endl;
+			return;
+		}
+
 		size_t prevLength = 0;
-		for (std::filesystem::directory_entry p : std::filesystem::recursive_directory_iterator(m_dataPath))
+		for (const std::filesystem::directory_entry& p : std::filesystem::recursive_directory_iterator(m_dataPath))
 		{
 			std::filesystem::path pp = p.path();
 			if (pp.extension() == ".mps")
@@ -191,11 +429,31 @@ private:
 		std::cout << "\rLoading Maps ... Done" << std::setfill(' ') << std::setw(prevLength) << "" << std::endl;
 	}
 
+	void loadArchiveMaps()
+	{
+		for (auto& [key, file] : m_archiveFiles)
+		{
+			if (archiveKey(file.path.extension()) != L".mps") continue;
+
+			try
+			{
+				m_maps.push_back(Map(file.path, std::move(file.data)));
+			}
+			catch ([[maybe_unused]] const WolfRPGException& e)
+			{
+				// Same as for extracted maps, files which fail to parse are skipped
+			}
+		}
+	}
+
 	void loadCommonEvents()
 	{
 		std::cout << "Loading CommonEvents ... " << std::flush;
 
-		m_commonEvents = CommonEvents(m_dataPath / "BasicData/CommonEvent.dat", m_saveUncompressed);
+		if (fromArchive())
+			m_commonEvents = CommonEvents(m_dataPath / "BasicData/CommonEvent.dat", takeArchiveFile(m_dataPath / "BasicData/CommonEvent.dat"));
+		else
+			m_commonEvents = CommonEvents(m_dataPath / "BasicData/CommonEvent.dat", m_saveUncompressed);
 
 		std::cout << "Done" << std::endl;
 	}
@@ -204,7 +462,14 @@ private:
 	{
 		std::cout << "Loading Databases ... " << std::flush;
 
-		for (std::filesystem::directory_entry p : std::filesystem::directory_iterator(m_dataPath / "BasicData"))
+		if (fromArchive())
+		{
+			loadArchiveDatabases();
+			std::cout << "Done" << std::endl;
+			return;
+		}
+
+		for (const std::filesystem::directory_entry& p : std::filesystem::directory_iterator(m_dataPath / "BasicData"))
 		{
 			std::filesystem::path pp = p.path();
 			if (pp.extension() == ".project" && pp.filename() != "SysDataBaseBasic.project")
@@ -219,6 +484,29 @@ private:
 		std::cout << "Done" << std::endl;
 	}
 
+	void loadArchiveDatabases()
+	{
+		const tString basicDataKey = archiveKey(m_dataPath / "BasicData");
+
+		for (auto& [key, file] : m_archiveFiles)
+		{
+			if (archiveKey(file.path.parent_path()) != basicDataKey) continue;
+			if (archiveKey(file.path.extension()) != L".project" || archiveKey(file.path.filename()) == L"sysdatabasebasic.project") continue;
+
+			std::filesystem::path datFile = file.path;
+			datFile.replace_extension(".dat");
+
+			m_databases.push_back(Database(file.path, std::move(file.data), datFile, takeArchiveFile(datFile)));
+		}
+	}
+
+private:
+	struct ArchiveFile
+	{
+		std::filesystem::path path;
+		Bytes data;
+	};
+
 private:
 	std::filesystem::path m_dataPath;
 	bool m_skipGD;
@@ -229,5 +517,19 @@ private:
 	CommonEvents m_commonEvents;
 	Databases m_databases;
 
+	// Game files extracted from archives, keyed by their lower case path (see archiveKey)
+	std::map<tString, ArchiveFile> m_archiveFiles = {};
+	// Archives the game was loaded from, their remaining files are carried over by Save2Archive
+	std::vector<std::filesystem::path> m_sourceArchives = {};
+
+	// Common event ID -> commands calling it (see GetCommonEventCallers)
+	mutable std::optional<std::unordered_map<uint32_t, CallSites>> m_callers = std::nullopt;
+	mutable std::optional<CommandIndex> m_commandIndex                       = std::nullopt;
+
 	bool m_valid = false;
+
+	static constexpr uint32_t COMMON_EVENT_OFFSET = 500000;
+	static constexpr uint32_t COMMON_EVENT_RANGE  = 100000;
+
+	inline static const CallSites NO_CALLERS = {};
 };
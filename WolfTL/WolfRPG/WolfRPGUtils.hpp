@@ -38,6 +38,14 @@
 #include <sstream>
 #include <string>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 inline std::string BuildErrorTag(const std::source_location& location)
 {
 	std::string function = location.function_name();
@@ -82,7 +90,55 @@ inline std::string BuildJsonError(const std::string& key, const std::string& obj
 namespace wolfRPGUtils
 {
 static bool g_skipBackup = false;
+
+#ifdef __linux__
+// Copy the file inside the kernel, tries to create a reflink (copy-on-write clone) first and falls back to copy_file_range
+inline bool copyFileLinux(const std::filesystem::path& src, const std::filesystem::path& dst)
+{
+	const int srcFd = ::open(src.c_str(), O_RDONLY | O_CLOEXEC);
+	if (srcFd == -1) return false;
+
+	struct stat srcStat;
+	if (::fstat(srcFd, &srcStat) != 0)
+	{
+		::close(srcFd);
+		return false;
+	}
+
+	const int dstFd = ::open(dst.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, srcStat.st_mode & 0777);
+	if (dstFd == -1)
+	{
+		::close(srcFd);
+		return false;
+	}
+
+	bool success = false;
+
+#ifdef FICLONE
+	success = (::ioctl(dstFd, FICLONE, srcFd) == 0);
+#endif
+
+	if (!success)
+	{
+		off_t remaining = srcStat.st_size;
+		while (remaining > 0)
+		{
+			const ssize_t copied = ::copy_file_range(srcFd, nullptr, dstFd, nullptr, static_cast<std::size_t>(remaining), 0);
+			if (copied <= 0) break;
+
+			remaining -= copied;
+		}
+
+		success = (remaining == 0);
+	}
+
+	::close(dstFd);
+	::close(srcFd);
+
+	return success;
 }
+#endif
+} // namespace wolfRPGUtils
 
 template<typename T>
 inline std::string Dec2Hex(T i)
@@ -104,6 +160,29 @@ inline std::wstring Dec2HexW(T i)
 	return stream.str();
 }
 
+// Parses a hex string (e.g., "0F53E1") into bytes, whitespace is ignored
+inline Bytes HexToBytes(const std::string& hex)
+{
+	std::string digits;
+	for (const char& c : hex)
+	{
+		if (std::isspace(static_cast<unsigned char>(c))) continue;
+		if (!std::isxdigit(static_cast<unsigned char>(c)))
+			throw WolfRPGException(std::format("{}Invalid hex character '{}'", ERROR_TAG, c));
+
+		digits.push_back(c);
+	}
+
+	if (digits.size() % 2 != 0)
+		throw WolfRPGException(std::format("{}Hex string has an odd number of digits", ERROR_TAG));
+
+	Bytes bytes;
+	for (std::size_t i = 0; i < digits.size(); i += 2)
+		bytes.push_back(static_cast<uint8_t>(std::stoul(digits.substr(i, 2), nullptr, 16)));
+
+	return bytes;
+}
+
 inline const std::filesystem::path GetFileName(const std::filesystem::path& file)
 {
 	return file.filename();
@@ -114,6 +193,30 @@ inline const std::filesystem::path GetFileNameNoExt(const std::filesystem::path&
 	return file.stem();
 }
 
+// Copy a file, overwriting the destination. Uses copy-on-write clones or in-kernel copies where possible,
+// i.e., on file systems supporting reflinks (Btrfs, XFS, ReFS) no data is duplicated at all.
+inline void CopyFileFast(const std::filesystem::path& src, const std::filesystem::path& dst)
+{
+#ifdef _WIN32
+	// CopyFileW makes use of block cloning on file systems which support it
+	if (CopyFileW(src.wstring().c_str(), dst.wstring().c_str(), FALSE)) return;
+#elif defined(__linux__)
+	if (wolfRPGUtils::copyFileLinux(src, dst)) return;
+#endif
+
+	std::filesystem::copy_file(src, dst, std::filesystem::copy_options::overwrite_existing);
+}
+
+// Assign the value and report whether it differs from the previous one
+template<typename T, typename U>
+inline bool UpdateValue(T& target, U&& value)
+{
+	if (target == value) return false;
+
+	target = std::forward<U>(value);
+	return true;
+}
+
 inline void CreateBackup(const std::filesystem::path& filePath)
 {
 	// If the skip backup flag is set, do not create a backup
@@ -129,7 +232,7 @@ inline void CreateBackup(const std::filesystem::path& filePath)
 	if (std::filesystem::exists(bakPath)) return;
 
 	// Create a backup of the file
-	std::filesystem::copy_file(filePath, bakPath);
+	CopyFileFast(filePath, bakPath);
 }
 
 inline tString StrReplaceAll(tString str, const tString& from, const tString& to)
@@ -186,4 +289,5 @@ inline void CheckAndCreateDir(const std::filesystem::path& path)
 	}
 }
 
-inline std::filesystem::path g_activeFile = L"";
\ No newline at end of file
+// File processed by the current thread, used to give context to error messages
+inline thread_local std::filesystem::path g_activeFile = L"";
\ No newline at end of file
@@ -36,6 +36,10 @@
 
 #include <CLI11/CLI11.hpp>
 
+#include "WolfRPG/Bundle.hpp"
+#include "WolfRPG/Parallel.hpp"
+#include "WolfRPG/SparsePatch.hpp"
+#include "WolfRPG/TextTable.hpp"
 #include "WolfRPG/WolfRPG.hpp"
 
 namespace fs = std::filesystem;
@@ -86,6 +90,8 @@ class WolfTL
 	inline static const std::filesystem::path DB_OUTPUT    = OUTPUT_DIR / "db";
 	inline static const std::filesystem::path COM_OUTPUT   = OUTPUT_DIR / "common";
 	inline static const std::filesystem::path PATCHED_DATA = "patched/data";
+	inline static const std::filesystem::path BUNDLE_FILE  = "dump.bundle";
+	inline static const std::filesystem::path TEXT_TABLE   = "texts.jsonl";
 
 public:
 	WolfTL(const fs::path& dataPath, const fs::path& outputPath, const bool& skipGD = false, const bool& saveUncompressed = false) :
@@ -101,18 +107,95 @@ public:
 		return m_wolf.Valid();
 	}
 
-	void ToJson() const
+	// Lists the maps of the game, only their headers are read (see Map::Probe), i.e., the game is not loaded
+	static void Inspect(const fs::path& dataPath)
+	{
+		bool found = false;
+
+		if (fs::exists(dataPath / "BasicData") || !fs::exists(dataPath / "Data.wolf"))
+		{
+			for (const fs::directory_entry& p : fs::recursive_directory_iterator(dataPath))
+			{
+				if (p.path().extension() != ".mps") continue;
+
+				found = true;
+				printMapInfo(p.path(), [&]() { return Map::Probe(p.path()); });
+			}
+		}
+
+		DxArchive::DeriveKey(dataPath);
+
+		for (const fs::directory_entry& p : fs::directory_iterator(dataPath))
+		{
+			if (!isExtension(p.path(), ".wolf")) continue;
+
+			DxArchive archive(p.path());
+
+			std::vector<const DxArchive::Entry*> entries;
+			for (const DxArchive::Entry& entry : archive.GetEntries())
+			{
+				if (isExtension(entry.path, ".mps"))
+					entries.push_back(&entry);
+			}
+
+			std::vector<Bytes> data = archive.Extract(entries);
+
+			for (std::size_t i = 0; i < entries.size(); i++)
+			{
+				const fs::path filePath = p.path().filename() / entries[i]->path;
+
+				found = true;
+				printMapInfo(filePath, [&]() { return Map::Probe(filePath, std::move(data[i])); });
+			}
+		}
+
+		if (!found)
+			std::cout << "No maps found in " << dataPath.string() << std::endl;
+	}
+
+	void ToJson(const bool& bundled = false) const
 	{
 		if (!m_wolf.Valid())
 			throw std::runtime_error(std::format("{}WolfRPG initialization failed", ERROR_TAG));
 
+		if (bundled)
+		{
+			toBundle();
+			return;
+		}
+
 		maps2Json();
 		databases2Json();
 		commonEvents2Json();
 		gameDat2Json();
 	}
 
-	void Patch(const bool& inplace = false)
+	// Writes only the translatable texts into a flat table instead of the complete dump,
+	// deduplicated every distinct text is written once with the keys of all its occurrences
+	void ExportTexts(const bool& deduplicate = false) const
+	{
+		if (!m_wolf.Valid())
+			throw std::runtime_error(std::format("{}WolfRPG initialization failed", ERROR_TAG));
+
+		std::cout << "Writing text table ... " << std::flush;
+
+		TextTable table;
+
+		for (const Map& map : m_wolf.GetMaps())
+			map.ExportTexts(table);
+
+		for (const Database& db : m_wolf.GetDatabases())
+			db.ExportTexts(table);
+
+		m_wolf.GetCommonEvents().ExportTexts(table);
+
+		CheckAndCreateDir(m_outputPath);
+		const std::size_t written = table.Write(m_outputPath / TEXT_TABLE, deduplicate);
+
+		std::cout << "Done (" << written << " entries)" << std::endl;
+	}
+
+	void Patch(const bool& inplace = false, const bool& toArchive = false, const fs::path& sparsePatch = {}, const bool& bundled = false, const bool& textTable = false)
 	{
 		// Skip backup if not patching in-place
 		wolfRPGUtils::g_skipBackup = !inplace;
@@ -120,20 +203,147 @@ public:
 		if (!m_wolf.Valid())
 			throw std::runtime_error("WolfRPG initialization failed");
 
-		// Check if the patch folder exists
-		if (!fs::exists(m_outputPath))
-			throw std::runtime_error(std::format("{}Patch folder does not exist: {}", ERROR_TAG, m_outputPath.string()));
-
-		patchMaps(m_outputPath);
-		patchDatabases(m_outputPath);
-		patchCommonEvents(m_outputPath);
-		patchGameDat(m_outputPath);
+		if (textTable)
+			applyTextTable();
+		else if (bundled)
+			applyBundle();
+		else if (sparsePatch.empty())
+		{
+			// Check if the patch folder exists
+			if (!fs::exists(m_outputPath))
+				throw std::runtime_error(std::format("{}Patch folder does not exist: {}", ERROR_TAG, m_outputPath.string()));
+
+			patchMaps(m_outputPath);
+			patchDatabases(m_outputPath);
+			patchCommonEvents(m_outputPath);
+			patchGameDat(m_outputPath);
+		}
+		else
+			applySparsePatch(sparsePatch);
 
 		// Save the patched data
-		m_wolf.Save2File((inplace ? m_dataPath : (m_outputPath / PATCHED_DATA)));
+		const fs::path targetPath = (inplace ? m_dataPath : (m_outputPath / PATCHED_DATA));
+
+		if (toArchive)
+		{
+			CheckAndCreateDir(targetPath);
+			m_wolf.Save2Archive(targetPath / "Data.wolf");
+		}
+		else
+			m_wolf.Save2File(targetPath);
 	}
 
 private:
+	template<typename Func>
+	static void printMapInfo(const fs::path& filePath, Func&& probe)
+	{
+		try
+		{
+			const MapInfo info = probe();
+
+			std::cout << std::format("{}: version {:#x}, tileset {}, {}x{}, {} layers, {} events", filePath.generic_string(), info.version, info.tilesetID, info.width, info.height, info.layerCount, info.eventCount) << std::endl;
+
+			for (const MapInfo::EventHeader& ev : info.events)
+				std::cout << std::format("    {:>4} \"{}\" at ({}, {}), {} pages", ev.id, ToUTF8(ev.name), ev.x, ev.y, ev.pageCount) << std::endl;
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << filePath.generic_string() << ": failed to read the header" << std::endl
+					  << e.what() << std::endl;
+		}
+	}
+
+	// Archive file names are case insensitive
+	static bool isExtension(const fs::path& filePath, const std::string& extension)
+	{
+		std::string ext = filePath.extension().string();
+		std::transform(ext.begin(), ext.end(), ext.begin(), [](const char& c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+		return (ext == extension);
+	}
+
+	// Writes the dump into a single bundle file instead of one file per entry
+	void toBundle() const
+	{
+		CheckAndCreateDir(m_outputPath);
+
+		Bundle::Writer writer(m_outputPath);
+
+		FileWriter::SetSink([&](const std::filesystem::path& filePath, Bytes data) {
+			writer.Add(filePath, std::move(data));
+		});
+
+		try
+		{
+			maps2Json();
+			databases2Json();
+			commonEvents2Json();
+			gameDat2Json();
+		}
+		catch (...)
+		{
+			FileWriter::SetSink(nullptr);
+			throw;
+		}
+
+		FileWriter::SetSink(nullptr);
+
+		std::cout << "Writing " << BUNDLE_FILE.string() << " ... " << std::flush;
+		writer.Write(m_outputPath / BUNDLE_FILE);
+		std::cout << "Done" << std::endl;
+	}
+
+	void applyBundle()
+	{
+		const fs::path bundlePath = m_outputPath / BUNDLE_FILE;
+
+		if (!fs::exists(bundlePath))
+			throw std::runtime_error(std::format("{}Bundle file does not exist: {}", ERROR_TAG, bundlePath.string()));
+
+		const Bundle bundle(bundlePath);
+		JsonStream::SetBundle(&bundle);
+
+		m_bundled = true;
+
+		try
+		{
+			patchMaps(m_outputPath);
+			patchDatabases(m_outputPath);
+			patchCommonEvents(m_outputPath);
+			patchGameDat(m_outputPath);
+		}
+		catch (...)
+		{
+			JsonStream::SetBundle(nullptr);
+			throw;
+		}
+
+		JsonStream::SetBundle(nullptr);
+	}
+
+	void applyTextTable()
+	{
+		std::cout << "Applying text table ... " << std::flush;
+
+		const fs::path tablePath = m_outputPath / TEXT_TABLE;
+
+		if (!fs::exists(tablePath))
+			throw std::runtime_error(std::format("{}Text table does not exist: {}", ERROR_TAG, tablePath.string()));
+
+		const TextTable table(tablePath);
+
+		for (Map& map : m_wolf.GetMaps())
+			map.ApplyTexts(table);
+
+		for (Database& db : m_wolf.GetDatabases())
+			db.ApplyTexts(table);
+
+		m_wolf.GetCommonEvents().ApplyTexts(table);
+
+		table.CheckUnused();
+
+		std::cout << "Done (" << table.Size() << " entries)" << std::endl;
+	}
+
 	void maps2Json() const
 	{
 		std::cout << "Writing Maps to JSON ... " << std::flush;
@@ -141,7 +351,8 @@ private:
 		const std::filesystem::path mapOutput = m_outputPath / MAP_OUTPUT;
 
 		// Make sure the output folder exists
-		fs::create_directories(mapOutput);
+		if (!FileWriter::HasSink())
+			fs::create_directories(mapOutput);
 
 		for (const Map& map : m_wolf.GetMaps())
 			map.ToJson(mapOutput);
@@ -156,7 +367,8 @@ private:
 		const std::filesystem::path dbOutput = m_outputPath / DB_OUTPUT;
 
 		// Make sure the output folder exists
-		fs::create_directories(dbOutput);
+		if (!FileWriter::HasSink())
+			fs::create_directories(dbOutput);
 
 		for (const Database& db : m_wolf.GetDatabases())
 			db.ToJson(dbOutput);
@@ -171,7 +383,8 @@ private:
 		const std::filesystem::path comOutput = m_outputPath / COM_OUTPUT;
 
 		// Make sure the output folder exists
-		fs::create_directories(comOutput);
+		if (!FileWriter::HasSink())
+			fs::create_directories(comOutput);
 
 		m_wolf.GetCommonEvents().ToJson(comOutput);
 
@@ -198,11 +411,21 @@ private:
 		const std::filesystem::path mapPatch = patchFolder / MAP_OUTPUT;
 
 		// Check if the patch folder exists
-		if (!fs::exists(mapPatch))
+		if (!m_bundled && !fs::exists(mapPatch))
 			throw std::runtime_error(std::format("{}Map patch folder does not exist: {}", ERROR_TAG, mapPatch.string()));
 
-		for (Map& map : m_wolf.GetMaps())
-			map.Patch(mapPatch);
+		// The maps are independent of each other, i.e., their patch files can be parsed and applied in parallel
+		Maps& maps = m_wolf.GetMaps();
+		ParallelFor(maps.size(), [&](const std::size_t& i) {
+			try
+			{
+				maps[i].Patch(mapPatch);
+			}
+			catch (const std::exception& e)
+			{
+				throw WolfRPGException(std::format("Error while processing: {}\n{}", g_activeFile.string(), e.what()));
+			}
+		});
 
 		std::cout << "Done" << std::endl;
 	}
@@ -214,7 +437,7 @@ private:
 		const std::filesystem::path dbPatch = patchFolder / DB_OUTPUT;
 
 		// Check if the patch folder exists
-		if (!fs::exists(dbPatch))
+		if (!m_bundled && !fs::exists(dbPatch))
 			throw std::runtime_error(std::format("{}Database patch folder does not exist: {}", ERROR_TAG, dbPatch.string()));
 
 		for (Database& db : m_wolf.GetDatabases())
@@ -230,7 +453,7 @@ private:
 		const std::filesystem::path comPatch = patchFolder / COM_OUTPUT;
 
 		// Check if the patch folder exists
-		if (!fs::exists(comPatch))
+		if (!m_bundled && !fs::exists(comPatch))
 			throw std::runtime_error(std::format("{}Common event patch folder does not exist: {}", ERROR_TAG, comPatch.string()));
 
 		m_wolf.GetCommonEvents().Patch(comPatch);
@@ -238,6 +461,18 @@ private:
 		std::cout << "Done" << std::endl;
 	}
 
+	void applySparsePatch(const fs::path& patchFile)
+	{
+		std::cout << "Applying sparse patch ... " << std::flush;
+
+		if (!fs::exists(patchFile))
+			throw std::runtime_error(std::format("{}Sparse patch file does not exist: {}", ERROR_TAG, patchFile.string()));
+
+		const std::size_t changed = SparsePatch(m_wolf).Apply(patchFile);
+
+		std::cout << "Done (" << changed << " entries changed)" << std::endl;
+	}
+
 	void patchGameDat(const fs::path& patchFolder)
 	{
 		if (m_skipGD) return;
@@ -256,6 +491,7 @@ private:
 	fs::path m_outputPath;
 	WolfRPG m_wolf;
 	bool m_skipGD;
+	bool m_bundled = false;
 };
 
 int main(int argc, char* argv[])
@@ -266,7 +502,19 @@ int main(int argc, char* argv[])
 	bool inplacePatch     = false;
 	bool bCreate          = false;
 	bool bPatch           = false;
+	bool bInspect         = false;
 	bool saveUncompressed = false;
+	bool flatCommands     = false;
+	bool compactDb        = false;
+	bool compactDbAll     = false;
+	bool argStats         = false;
+	bool toArchive        = false;
+	bool bundled          = false;
+	bool textTable        = false;
+	bool textMemory       = false;
+	tString cacheFolder   = TEXT("");
+	tString sparseFile    = TEXT("");
+	std::string dxaKey    = "";
 
 	std::string oldMode = "";
 	bool useOldArgs     = false;
@@ -319,24 +567,75 @@ int main(int argc, char* argv[])
 		app.set_version_flag("-v,--version", PROG_WITH_VER);
 
 		app.add_option("DATA_PATH", dataFolder, "Path to the data folder of the Wolf RPG game")->required();
-		app.add_option("OUTPUT_PATH", outputFolder, "Path to the output folder, in patch mode this is the folder containing the created dump")->required();
+		app.add_option("OUTPUT_PATH", outputFolder, "Path to the output folder, in patch mode this is the folder containing the created dump, not required for --inspect");
 		app.add_flag("--skip-game_dat", skipGameDat, "Skip the processing of Game.dat");
 		app.add_flag("--inplace", inplacePatch, "Apply the patch in place, i.e., override the original data files");
 		app.add_flag("-s,--save_uncompressed", saveUncompressed, "Saves uncompressed versions of compressed files for debugging");
+		app.add_flag("--flat_commands", flatCommands, "Store event commands by value in contiguous memory instead of as individual objects");
+		app.add_flag("--compact_db", compactDb, "Write the rows of the databases as arrays of their name and string values, the field names are only listed once per type");
+		app.add_flag("--compact_db_all", compactDbAll, "Like --compact_db, but the rows contain the values of all fields");
+		app.add_flag("--arg_stats", argStats, "Print the size distribution of the command arguments after processing");
+		app.add_option("--dxa_key", dxaKey, "Key of encrypted .wolf archives as hex string (12 bytes), overrides the key derived from Game.dat");
+		app.add_flag("--archive", toArchive, "Write the patched game files into a Data.wolf archive instead of into a folder");
+		app.add_flag("--bundle", bundled, "Write the dump into a single indexed file (dump.bundle) or apply the patch from it");
+		app.add_flag("--text_table", textTable, "Export only the translatable texts into a flat table (texts.jsonl) or apply the patch from it");
+		app.add_flag("--text_memory", textMemory, "Deduplicate the exported text table, every distinct text is stored once with the keys of all its occurrences");
+		app.add_option("--sparse", sparseFile, "Apply a sparse patch (JSON Lines file with only the changed entries) instead of the dump folder");
+		app.add_option("--cache", cacheFolder, "Folder to cache the decrypted and decompressed game files in, speeds up subsequent runs on the same game");
 
 		auto* pOperation = app.add_option_group("Operation", "Operation to perform")->fallthrough();
 		pOperation->add_flag("--create", bCreate, "Create a patch from the game data");
 		pOperation->add_flag("--patch", bPatch, "Apply a patch to the game data");
+		pOperation->add_flag("--inspect", bInspect, "List the maps of the game with their header and events without loading the game");
 		pOperation->require_option(1);
 
 		CLI11_PARSE(app, argc, argv);
+
+		if (!bInspect && outputFolder.empty())
+		{
+			std::cerr << "OUTPUT_PATH is required" << std::endl
+					  << "Run with --help for more information." << std::endl;
+			return 1;
+		}
 	}
 
 	// Needs to be done after CLI11_PARSE or the help printing does not work
 	EnableUTF8Print();
 
 	fs::path dataPath   = fs::absolute(fs::path(dataFolder));
-	fs::path outputPath = fs::absolute(fs::path(outputFolder));
+	fs::path outputPath = outputFolder.empty() ? fs::path() : fs::absolute(fs::path(outputFolder));
+
+	Command::Commands::SetFlatStorage(flatCommands);
+	Type::SetJsonLayout(compactDbAll ? Type::JsonLayout::CompactAll : (compactDb ? Type::JsonLayout::Compact : Type::JsonLayout::Fields));
+	SizeHistogram::Enable(argStats);
+
+	if (!cacheFolder.empty())
+		DecodeCache::SetDirectory(fs::absolute(fs::path(cacheFolder)));
+
+	try
+	{
+		DxArchive::SetKey(HexToBytes(dxaKey));
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Invalid archive key: " << e.what() << std::endl;
+		return 1;
+	}
+
+	if (bInspect)
+	{
+		try
+		{
+			WolfTL::Inspect(dataPath);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return 1;
+		}
+
+		return 0;
+	}
 
 	try
 	{
@@ -349,11 +648,19 @@ int main(int argc, char* argv[])
 		}
 
 		if (bCreate)
-			wolf.ToJson();
+		{
+			if (textTable || textMemory)
+				wolf.ExportTexts(textMemory);
+			else
+				wolf.ToJson(bundled);
+		}
 		else if (bPatch)
-			wolf.Patch(inplacePatch);
+			wolf.Patch(inplacePatch, toArchive, sparseFile.empty() ? fs::path() : fs::absolute(fs::path(sparseFile)), bundled, textTable || textMemory);
 		else
 			std::wcerr << L"No valid mode selected" << std::endl;
+
+		if (argStats)
+			Command::Command::PrintArgStatistics(std::cout);
 	}
 	catch (const std::exception& e)
 	{